@@ -0,0 +1,97 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+std::atomic<bool> isCounting = false;
+std::atomic<size_t> numAllocations = 0;
+std::atomic<size_t> numBytes = 0;
+std::atomic<int64_t> numLiveBytes = 0;
+std::atomic<int64_t> numPeakBytes = 0;
+
+// The live bytes are tracked with the size the heap reserved for a block, so delete needs no size header and blocks
+// allocated while counting was off can be freed the same way
+int64_t blockSize(void* block) {
+    return static_cast<int64_t>(_msize(block));
+}
+
+void* allocate(size_t size) {
+    void* block = std::malloc(size);
+    if (block == nullptr)
+        throw std::bad_alloc();
+    if (!isCounting.load(std::memory_order_relaxed))
+        return block;
+
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    numBytes.fetch_add(size, std::memory_order_relaxed);
+    int64_t reserved = blockSize(block);
+    int64_t live = numLiveBytes.fetch_add(reserved, std::memory_order_relaxed) + reserved;
+    int64_t peak = numPeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !numPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return block;
+}
+
+void deallocate(void* pointer) {
+    if (pointer == nullptr)
+        return;
+    if (isCounting.load(std::memory_order_relaxed))
+        numLiveBytes.fetch_sub(blockSize(pointer), std::memory_order_relaxed);
+    std::free(pointer);
+}
+
+} // namespace
+
+AllocationStats AllocationStats::operator-(const AllocationStats& other) const {
+    return AllocationStats{allocations - other.allocations, bytes - other.bytes};
+}
+
+void setAllocationCounting(bool isEnabled) {
+    isCounting.store(isEnabled, std::memory_order_relaxed);
+}
+
+AllocationStats allocationStats() {
+    return AllocationStats{numAllocations.load(std::memory_order_relaxed), numBytes.load(std::memory_order_relaxed)};
+}
+
+size_t liveBytes() {
+    return static_cast<size_t>(numLiveBytes.load(std::memory_order_relaxed));
+}
+
+size_t peakBytes() {
+    return static_cast<size_t>(numPeakBytes.load(std::memory_order_relaxed));
+}
+
+void resetPeakBytes() {
+    numPeakBytes.store(numLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// Over-aligned new/delete keep their default implementation, only plain allocations are counted
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    deallocate(pointer);
+}
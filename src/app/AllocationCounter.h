@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+// Heap allocations of the whole process, counted by the replaced global operator new in AllocationCounter.cpp once
+// setAllocationCounting(true) was called. Counting is off by default, then new and delete only forward to malloc and free.
+struct AllocationStats {
+    size_t allocations = 0;
+    size_t bytes = 0;
+
+    AllocationStats operator-(const AllocationStats& other) const;
+};
+
+void setAllocationCounting(bool isEnabled);
+
+AllocationStats allocationStats();
+
+// Bytes currently allocated, and the most that were allocated at once since the last resetPeakBytes(). Blocks allocated
+// before counting was enabled are subtracted when they are freed, so only differences of these values are meaningful.
+size_t liveBytes();
+size_t peakBytes();
+void resetPeakBytes();
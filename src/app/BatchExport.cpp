@@ -0,0 +1,422 @@
+#include "BatchExport.h"
+#include "ExportManifest.h"
+#include "MeshExporter.h"
+
+#include <parser/BoundedQueue.h>
+#include <parser/Bundle.h>
+#include <parser/CommonPath.h>
+#include <parser/PackageParser.h>
+#include <parser/SceneParser.h>
+#include <parser/SharkParser.h>
+#include <parser/ThreadPool.h>
+#include <parser/Utils.h>
+
+#include <spdlog/spdlog.h>
+
+#include <DirectXTex.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <set>
+#include <thread>
+
+using namespace parser;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Bump when the exporter writes different FBX files for the same input, every SIR is exported again
+const uint32_t exporterVersion = 1;
+const ExportMode exportMode = ExportMode::Multiple;
+
+struct SirExport {
+    const SirEntry* sir;
+    uint64_t inputHash;
+};
+
+// Export state of one bundle, the bundle is flushed and released once its last SIR is done
+struct BundleExport {
+    std::string name;
+    std::unique_ptr<Bundle> bundle;
+    SceneIndex sceneIndex;
+    std::vector<SirExport> sirs; // the SIRs to export, unchanged ones aren't in it
+    std::unique_ptr<ExportManifest> manifest;
+    uintmax_t bundleSize = 0;
+    Clock::time_point start;
+    bool isLoaded = false;
+
+    std::atomic<size_t> numRemaining = 0;
+    std::atomic<size_t> numExported = 0;
+    std::atomic<size_t> numFailed = 0;
+    size_t numSkipped = 0;
+};
+
+// Chains the byte range a file is read from into `hash`, so any change of the file changes the hash
+uint64_t hashSource(uint64_t hash, const std::filesystem::path& path) {
+    auto source = PackageParser::instance().findSource(path);
+    if (source.has_value()) {
+        hash = Utils::hashBytes(&source->pakStamp, sizeof(source->pakStamp), hash);
+        hash = Utils::hashBytes(&source->offset, sizeof(source->offset), hash);
+        return Utils::hashBytes(&source->size, sizeof(source->size), hash);
+    }
+
+    // Not packed, falls back to the size and write time of the file on disk
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    int64_t ticks = error ? 0 : static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    hash = Utils::hashBytes(&size, sizeof(size), hash);
+    return Utils::hashBytes(&ticks, sizeof(ticks), hash);
+}
+
+// Inputs shared by every SIR of the bundle: the exporter options, the .bun and the textures it references
+uint64_t hashBundleInputs(const Bundle& bundle) {
+    uint64_t hash = Utils::hashBytes(&exporterVersion, sizeof(exporterVersion));
+    hash = Utils::hashBytes(&exportMode, sizeof(exportMode), hash);
+    hash = hashSource(hash, bundlesFolderPath / (bundle.name() + ".bun"));
+    for (const auto& texture : bundle.header().textures)
+        hash = hashSource(hash, texture);
+    return hash;
+}
+
+std::vector<std::string> resolveBundleNames(const std::vector<std::string>& patterns) {
+    std::set<std::string> available;
+    for (const auto& bundlePath : PackageParser::instance().filenamesWithExtension(".bun"))
+        available.insert(Utils::getFilenameWithoutExtension(bundlePath));
+
+    std::set<std::string> result;
+    for (const auto& pattern : patterns) {
+        size_t numMatched = 0;
+        for (const auto& name : available) {
+            if (pattern == "all" || Utils::matchesGlob(name, pattern)) {
+                result.insert(name);
+                ++numMatched;
+            }
+        }
+        if (numMatched == 0)
+            spdlog::warn("No bundle matches '{}'", pattern);
+    }
+    return std::vector<std::string>(result.begin(), result.end());
+}
+
+// A parsed SIR on its way through the texture and write stages
+struct SceneItem {
+    BundleExport* state;
+    SirExport sirExport;
+    FlatScene scene;
+    std::vector<TextureJob> textureJobs;
+    double parseTime = 0.0;
+    double textureTime = 0.0;
+};
+
+// Time the threads of a pipeline stage spent working and waiting for room in the next queue
+struct StageStats {
+    std::string name;
+    size_t numThreads = 0;
+    std::atomic<int64_t> busy = 0;    // ns
+    std::atomic<int64_t> blocked = 0; // ns
+    std::atomic<size_t> numItems = 0;
+
+    static void add(std::atomic<int64_t>& counter, Clock::duration duration) {
+        counter += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    void print(double wallTime) const {
+        const double available = std::max(wallTime * numThreads, 1e-9) * 1e9;
+        const double busyShare = 100.0 * busy / available;
+        const double blockedShare = 100.0 * blocked / available;
+        spdlog::info("Stage {:<8}: {} threads, {} items, busy {:.1f}%, blocked on the next stage {:.1f}%, idle {:.1f}%",
+                     name,
+                     numThreads,
+                     numItems.load(),
+                     busyShare,
+                     blockedShare,
+                     std::max(0.0, 100.0 - busyShare - blockedShare));
+    }
+};
+
+// Three stages connected by bounded queues: SIRs are parsed on the work-stealing pool, their textures converted
+// on the texture threads and the FBX files written by a single writer, so parsing the next SIRs overlaps the rest
+class BatchExporter {
+public:
+    BatchExporter(const ExportOptions& options)
+            : m_options(options)
+            , m_textureQueue(2 * std::max<size_t>(options.numJobs, 1))
+            , m_writeQueue(std::max<size_t>(options.numJobs, 1))
+            , m_threadPool(options.numJobs, [] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); }) {
+        m_parseStats.name = "parse";
+        m_parseStats.numThreads = m_threadPool.size();
+        m_textureStats.name = "textures";
+        m_textureStats.numThreads = m_threadPool.size();
+        m_writeStats.name = "write";
+        m_writeStats.numThreads = 1;
+    }
+
+    // Bundles are loaded on the pool too, so the SIRs of a bundle start while the next bundle is loaded
+    void run(const std::vector<std::string>& bundleNames) {
+        std::vector<std::thread> textureThreads;
+        for (size_t i = 0; i < m_textureStats.numThreads; ++i)
+            textureThreads.emplace_back([this] { convertTextures(); });
+        std::thread writeThread([this] { writeScenes(); });
+
+        for (const auto& bundleName : bundleNames) {
+            auto& bundleExport = m_bundles.emplace_back(std::make_unique<BundleExport>());
+            bundleExport->name = bundleName;
+            m_threadPool.submit([this, state = bundleExport.get()] {
+                const auto start = Clock::now();
+                try {
+                    loadBundle(*state);
+                }
+                catch (const std::exception& exception) {
+                    spdlog::error("Bundle '{}' not loaded: {}", state->name, exception.what());
+                }
+                StageStats::add(m_parseStats.busy, Clock::now() - start);
+            });
+        }
+
+        m_threadPool.wait();
+        m_textureQueue.close();
+        for (std::thread& thread : textureThreads)
+            thread.join();
+        m_writeQueue.close();
+        writeThread.join();
+    }
+
+    const std::vector<std::unique_ptr<BundleExport>>& bundles() const { return m_bundles; }
+
+    void printStageStats(double wallTime) const {
+        m_parseStats.print(wallTime);
+        m_textureStats.print(wallTime);
+        m_writeStats.print(wallTime);
+    }
+
+private:
+    void loadBundle(BundleExport& state) {
+        state.start = Clock::now();
+        std::filesystem::path sceneSDRPath = "data/generated/locations/" + state.name + ".cdr";
+        state.sceneIndex = parseSceneIndex(sceneSDRPath, state.name);
+
+        std::error_code error;
+        state.bundleSize = std::filesystem::file_size(bundlesFolderPath / (state.name + ".bun"), error);
+        state.bundle = std::make_unique<Bundle>(state.name);
+        state.manifest = std::make_unique<ExportManifest>(outputPath(state) / "export.manifest");
+        state.isLoaded = true;
+
+        const uint64_t bundleHash = hashBundleInputs(*state.bundle);
+        std::vector<SirEntry*> outdated;
+        for (auto& sir : state.sceneIndex.sirs) {
+            if (sir.filename.find("anim") == 0)
+                continue;
+
+            if (!m_options.meshName.empty() && sir.filename.find(m_options.meshName) == std::string::npos)
+                continue;
+
+            const uint64_t inputHash = hashSource(bundleHash, sir.sirPath);
+            const bool isWritten = std::filesystem::exists(outputPath(state) / (sir.filename + ".fbx"), error);
+            if (m_options.isIncremental && isWritten && state.manifest->isUpToDate(sir.filename, inputHash)) {
+                spdlog::debug("SIR: '{}' is up to date", sir.filename);
+                ++state.numSkipped;
+                continue;
+            }
+
+            state.sirs.push_back(SirExport{&sir, inputHash});
+            outdated.push_back(&sir);
+        }
+
+        state.numRemaining = state.sirs.size();
+        if (state.sirs.empty()) {
+            finishBundle(state);
+            return;
+        }
+
+        // The hierarchies of the SIRs to export are parsed as one batch, this job runs queued jobs while it waits
+        parseSirDocuments(outdated, m_threadPool);
+        for (const SirExport& sirExport : state.sirs)
+            m_threadPool.submit([this, &state, sirExport] { parseSir(state, sirExport); });
+    }
+
+    // Parse stage, runs on the pool
+    void parseSir(BundleExport& state, const SirExport& sirExport) {
+        const SirEntry& sir = *sirExport.sir;
+        const auto start = Clock::now();
+        std::optional<SceneItem> item;
+        try {
+            SceneParser scene(sir, *state.bundle, true);
+            if (scene.flatScene.has_value())
+                item = SceneItem{&state, sirExport, std::move(*scene.flatScene), std::move(scene.textureJobs)};
+            else
+                spdlog::warn("SIR: '{}' not parsed", sir.filename);
+        }
+        catch (const std::exception& exception) {
+            spdlog::error("SIR: '{}' failed: {}", sir.filename, exception.what());
+        }
+        catch (...) {
+            spdlog::error("SIR: '{}' failed", sir.filename);
+        }
+        const auto parsed = Clock::now();
+        StageStats::add(m_parseStats.busy, parsed - start);
+        ++m_parseStats.numItems;
+
+        if (!item.has_value()) {
+            completeSir(state, sirExport, false);
+            return;
+        }
+
+        item->parseTime = std::chrono::duration<double>(parsed - start).count();
+        m_textureQueue.push(std::move(*item));
+        StageStats::add(m_parseStats.blocked, Clock::now() - parsed);
+    }
+
+    // Texture stage, one loop per texture thread
+    void convertTextures() {
+        CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        while (auto item = m_textureQueue.pop()) {
+            const auto start = Clock::now();
+            bool isConverted = false;
+            try {
+                runTextureJobs(item->textureJobs, item->scene);
+                isConverted = true;
+            }
+            catch (const std::exception& exception) {
+                spdlog::error("SIR: '{}' textures failed: {}", item->sirExport.sir->filename, exception.what());
+            }
+            const auto converted = Clock::now();
+            StageStats::add(m_textureStats.busy, converted - start);
+            ++m_textureStats.numItems;
+
+            if (!isConverted) {
+                completeSir(*item->state, item->sirExport, false);
+                continue;
+            }
+
+            item->textureTime = std::chrono::duration<double>(converted - start).count();
+            m_writeQueue.push(std::move(*item));
+            StageStats::add(m_textureStats.blocked, Clock::now() - converted);
+        }
+    }
+
+    // Write stage, the FBX SDK is used from this thread only
+    void writeScenes() {
+        while (auto item = m_writeQueue.pop()) {
+            const auto start = Clock::now();
+            const SirEntry& sir = *item->sirExport.sir;
+            std::vector<FlatScene> scenes;
+            scenes.push_back(std::move(item->scene));
+            bool isExtracted = false;
+            try {
+                isExtracted = exportScene(scenes, outputPath(*item->state), exportMode);
+            }
+            catch (const std::exception& exception) {
+                spdlog::error("SIR: '{}' not written: {}", sir.filename, exception.what());
+            }
+            const auto written = Clock::now();
+            const std::chrono::duration<double> writeTime = written - start;
+            StageStats::add(m_writeStats.busy, written - start);
+            ++m_writeStats.numItems;
+
+            if (isExtracted)
+                spdlog::info("SIR: '{}' parsed in {:.3f} s, textures in {:.3f} s, written in {:.3f} s",
+                             sir.filename,
+                             item->parseTime,
+                             item->textureTime,
+                             writeTime.count());
+            else
+                spdlog::error("Scene: '{}' not extracted", sir.filename);
+            completeSir(*item->state, item->sirExport, isExtracted);
+        }
+    }
+
+    // Called once per SIR by whichever stage it ended in
+    void completeSir(BundleExport& state, const SirExport& sirExport, bool isExported) {
+        if (isExported) {
+            state.manifest->set(sirExport.sir->filename, sirExport.inputHash);
+            ++state.numExported;
+        }
+        else {
+            state.manifest->remove(sirExport.sir->filename);
+            ++state.numFailed;
+        }
+
+        if (--state.numRemaining == 0)
+            finishBundle(state);
+    }
+
+    void finishBundle(BundleExport& state) {
+        state.bundle->flush();
+        state.bundle.reset();
+        state.manifest->save();
+
+        const std::chrono::duration<double> time = Clock::now() - state.start;
+        const double seconds = std::max(time.count(), 1e-9);
+        spdlog::info("Bundle '{}': {} SIRs exported, {} failed, {} up to date in {:.3f} s ({:.2f} SIRs/s, {:.2f} MB/s)",
+                     state.name,
+                     state.numExported.load(),
+                     state.numFailed.load(),
+                     state.numSkipped,
+                     time.count(),
+                     state.numExported / seconds,
+                     state.bundleSize / seconds / (1024.0 * 1024.0));
+    }
+
+    static std::filesystem::path outputPath(const BundleExport& state) {
+        return std::filesystem::path("meshes") / state.name;
+    }
+
+    const ExportOptions& m_options;
+    std::vector<std::unique_ptr<BundleExport>> m_bundles;
+
+    StageStats m_parseStats;
+    StageStats m_textureStats;
+    StageStats m_writeStats;
+    BoundedQueue<SceneItem> m_textureQueue;
+    BoundedQueue<SceneItem> m_writeQueue;
+    ThreadPool m_threadPool;
+};
+
+} // namespace
+
+int runExport(const ExportOptions& options) {
+    std::vector<std::string> bundleNames = resolveBundleNames(options.bundlePatterns);
+    if (bundleNames.empty()) {
+        spdlog::error("Nothing to export");
+        return 1;
+    }
+
+    const auto start = Clock::now();
+    BatchExporter exporter(options);
+    exporter.run(bundleNames);
+    const std::chrono::duration<double> time = Clock::now() - start;
+    exporter.printStageStats(time.count());
+
+    size_t numExported = 0;
+    size_t numFailed = 0;
+    size_t numSkipped = 0;
+    size_t numLoaded = 0;
+    uintmax_t bundleBytes = 0;
+    for (const auto& state : exporter.bundles()) {
+        numExported += state->numExported;
+        numFailed += state->numFailed;
+        numSkipped += state->numSkipped;
+        if (state->isLoaded) {
+            ++numLoaded;
+            bundleBytes += state->bundleSize;
+        }
+    }
+
+    const double seconds = std::max(time.count(), 1e-9);
+    spdlog::info("{} of {} bundles exported with {} jobs in {:.3f} s: {} SIRs rebuilt ({} failed), {} skipped as unchanged",
+                 numLoaded,
+                 bundleNames.size(),
+                 options.numJobs,
+                 time.count(),
+                 numExported,
+                 numFailed,
+                 numSkipped);
+    spdlog::info("Throughput: {:.2f} SIRs/s, {:.2f} MB/s of bundle data",
+                 numExported / seconds,
+                 bundleBytes / seconds / (1024.0 * 1024.0));
+    return 0;
+}
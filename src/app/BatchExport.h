@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct ExportOptions {
+    std::vector<std::string> bundlePatterns; // bundle names, globs like "japan_*" or "all"
+    std::string meshName;                    // exports only the SIRs containing it, if set
+    size_t numJobs = 1;
+    bool isIncremental = true; // skips the SIRs whose inputs didn't change since the last export, see ExportManifest
+};
+
+// Headless export of every SIR of the matching bundles, started with --export. Returns the process exit code.
+int runExport(const ExportOptions& options);
@@ -0,0 +1,1257 @@
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+
+#include <parser/BinReader.h>
+#include <parser/BundleParser.h>
+#include <parser/CommonPath.h>
+#include <parser/MemoryStats.h>
+#include <parser/PackageParser.h>
+#include <parser/SceneParser.h>
+#include <parser/SceneTransforms.h>
+#include <parser/SharkBatch.h>
+#include <parser/SharkCache.h>
+#include <parser/SharkDumper.h>
+#include <parser/SharkParser.h>
+#include <parser/SharkQuery.h>
+#include <parser/SharkReader.h>
+#include <parser/ThreadPool.h>
+#include <parser/Utils.h>
+#include <parser/VertexDecoder.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+using namespace parser;
+
+namespace {
+
+template <typename Function>
+double measureSeconds(Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+SceneIndex loadSceneIndex(const std::string& bundleName) {
+    std::filesystem::path sceneSDRPath = "data/generated/locations/" + bundleName + ".cdr";
+    return parseSceneIndex(sceneSDRPath, bundleName);
+}
+
+std::vector<FlatScene> loadScenes(const SceneIndex& sceneIndex) {
+    Bundle bundle(sceneIndex.bundleName);
+    std::vector<FlatScene> scenes;
+    for (const auto& sir : sceneIndex.sirs) {
+        SceneParser scene(sir, bundle);
+        if (scene.flatScene.has_value())
+            scenes.push_back(std::move(*scene.flatScene));
+    }
+    bundle.flush();
+    return scenes;
+}
+
+// Loads every SIR of a bundle decoding meshes from the .bun and then from the mesh cache
+int meshCacheBenchmark(const BenchmarkOptions& options) {
+    SceneIndex sceneIndex = loadSceneIndex(options.bundleName);
+    auto loadAll = [&](bool useMeshCache) {
+        Bundle bundle(sceneIndex.bundleName, useMeshCache);
+        size_t numberOfMeshes = 0;
+        for (const auto& sir : sceneIndex.sirs) {
+            SceneParser scene(sir, bundle);
+            if (scene.flatScene.has_value())
+                numberOfMeshes += scene.flatScene->numberOfMeshes();
+        }
+        bundle.flush();
+        return numberOfMeshes;
+    };
+
+    // Warm up: exports textures and fills the page cache, so only mesh loading is measured
+    size_t numberOfMeshes = loadAll(false);
+
+    double decodeTime = 0.0;
+    for (int i = 0; i < options.iterations; ++i)
+        decodeTime += measureSeconds([&] { loadAll(false); });
+
+    std::filesystem::remove(cacheFolderPath / "meshes" / (options.bundleName + ".mcache"));
+    double buildTime = measureSeconds([&] { loadAll(true); });
+
+    double cachedTime = 0.0;
+    for (int i = 0; i < options.iterations; ++i)
+        cachedTime += measureSeconds([&] { loadAll(true); });
+
+    spdlog::info("{}: {} SIRs, {} mesh parts", options.bundleName, sceneIndex.sirs.size(), numberOfMeshes);
+    spdlog::info("decode from .bun: {:.3f}s", decodeTime / options.iterations);
+    spdlog::info("decode and write cache: {:.3f}s", buildTime);
+    spdlog::info("load from cache: {:.3f}s", cachedTime / options.iterations);
+    return 0;
+}
+
+// Decoding the way parseMesh did before VertexLayout: a BinReader seek and push_back per attribute
+void decodeVerticesPerVertex(const VertexLayout& layout, const std::vector<char>& buffer, Mesh& mesh) {
+    BinReaderMemory reader(buffer.data(), buffer.size());
+    for (size_t vi = 0; vi < buffer.size() / layout.stride; ++vi) {
+        reader.setPosition(vi * layout.stride + layout.channels[layout.position].offset);
+        mesh.vertices.push_back(reader.read<Vector3>());
+        if (layout.normal != -1) {
+            reader.setPosition(vi * layout.stride + layout.channels[layout.normal].offset);
+            mesh.normals.push_back(reader.read<Vector3>());
+        }
+        if (layout.uv != -1) {
+            reader.setPosition(vi * layout.stride + layout.channels[layout.uv].offset);
+            Vector2 uv = reader.read<Vector2>();
+            mesh.uvs.push_back(Vector2{uv.x, 1.0f - uv.y});
+        }
+    }
+}
+
+// Decodes synthetic vertices for every vertex format used by the extracted bundles
+int vertexDecodeBenchmark(const BenchmarkOptions& options) {
+    std::map<std::string, VertexLayout> layouts;
+    for (auto& bundlePath : std::filesystem::directory_iterator(bundlesFolderPath)) {
+        if (bundlePath.path().extension() != ".bun")
+            continue;
+        BundleHeader header = BundleParser(bundlePath.path()).parseHeader();
+        for (const StreamFormat& streamFormat : header.streamFormats) {
+            if (streamFormat.size == 0)
+                continue;
+            VertexLayout layout = VertexLayout::compile(streamFormat);
+            layouts.emplace(layout.name(), layout);
+        }
+    }
+
+    const size_t numVertices = 1 << 20;
+    for (const auto& [name, layout] : layouts) {
+        if (!layout.isSupported()) {
+            spdlog::info("{}: no position, not decoded", name);
+            continue;
+        }
+
+        std::vector<char> buffer(numVertices * layout.stride);
+        float* values = reinterpret_cast<float*>(buffer.data());
+        for (size_t i = 0; i < buffer.size() / sizeof(float); ++i)
+            values[i] = static_cast<float>(i % 1024) / 1024.0f;
+
+        double perVertexTime = 0.0;
+        double decoderTime = 0.0;
+        for (int i = 0; i < options.iterations; ++i) {
+            Mesh perVertexMesh;
+            perVertexTime += measureSeconds([&] { decodeVerticesPerVertex(layout, buffer, perVertexMesh); });
+            Mesh mesh;
+            decoderTime += measureSeconds([&] { decodeVertices(layout, buffer.data(), numVertices, mesh); });
+        }
+
+        double megabytes = static_cast<double>(buffer.size()) * options.iterations / (1024.0 * 1024.0);
+        spdlog::info("{} (stride {}): per-vertex {:.0f} MB/s, decoder {:.0f} MB/s",
+                     name,
+                     layout.stride,
+                     megabytes / perVertexTime,
+                     megabytes / decoderTime);
+    }
+    return 0;
+}
+
+// Parses every MeshInfo of a bundle with heap allocated tables and then with tables in a monotonic arena
+int meshInfoBenchmark(const BenchmarkOptions& options) {
+    BundleParser bundleParser(bundlesFolderPath / (options.bundleName + ".bun"));
+    BundleHeader header = bundleParser.parseHeader();
+    BinReaderMmap binReader(bundlesFolderPath / (options.bundleName + ".bun"));
+    binReader.setZeroPos(header.posZero);
+
+    size_t numMeshes = 0;
+    auto parseAll = [&](std::pmr::memory_resource* resource, std::pmr::monotonic_buffer_resource* arena) {
+        numMeshes = 0;
+        for (const BundleFileEntry& file : header.fileEntries) {
+            for (const MeshEntry& meshEntry : file.meshEntries) {
+                binReader.setPosition(meshEntry.posStart + header.posZero);
+                {
+                    MeshInfo info(resource);
+                    numMeshes += info.load(binReader) ? 1 : 0;
+                }
+                if (arena != nullptr)
+                    arena->release();
+            }
+        }
+    };
+
+    CountingResource heap;
+    double heapTime = 0.0;
+    for (int i = 0; i < options.iterations; ++i)
+        heapTime += measureSeconds([&] { parseAll(&heap, nullptr); });
+
+    CountingResource upstream;
+    std::vector<std::byte> buffer(64 * 1024);
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), &upstream);
+    double arenaTime = 0.0;
+    for (int i = 0; i < options.iterations; ++i)
+        arenaTime += measureSeconds([&] { parseAll(&arena, &arena); });
+
+    spdlog::info("{}: {} meshes", options.bundleName, numMeshes);
+    spdlog::info("heap: {:.3f}s, {} allocations per pass", heapTime / options.iterations, heap.allocations() / options.iterations);
+    spdlog::info("arena: {:.3f}s, {} allocations per pass", arenaTime / options.iterations, upstream.allocations() / options.iterations);
+    return 0;
+}
+
+// Poses the largest skinned mesh of a bundle: every bone turned about its own origin, the palette built from the
+// pose and the inverse bind pose each pass. Also counts the bones blended per vertex over every skinned mesh.
+int skinningBenchmark(const BenchmarkOptions& options) {
+    SceneIndex sceneIndex = loadSceneIndex(options.bundleName);
+    std::vector<FlatScene> scenes = loadScenes(sceneIndex);
+    std::vector<const Mesh*> meshes;
+    for (const FlatScene& scene : scenes) {
+        for (const Mesh& mesh : scene.meshes()) {
+            if (!mesh.skin.empty())
+                meshes.push_back(&mesh);
+        }
+    }
+
+    if (meshes.empty()) {
+        spdlog::error("{} has no skinned meshes", options.bundleName);
+        return 1;
+    }
+
+    // How many bones the decoded boneAssign weights blend per vertex
+    std::array<size_t, maxInfluences + 1> numVerticesByInfluences{};
+    for (const Mesh* skinned : meshes) {
+        for (const SkinVertex& skinVertex : skinned->skin.vertices)
+            ++numVerticesByInfluences[skinVertex.numInfluences()];
+    }
+
+    const Mesh& mesh = **std::max_element(meshes.begin(), meshes.end(), [](const Mesh* a, const Mesh* b) {
+        return a->vertices.size() < b->vertices.size();
+    });
+    std::vector<Vector3> posed(mesh.vertices.size());
+
+    // The bind pose has to give back the mesh as it is stored
+    const std::vector<BoneMatrix> bindPose = mesh.skin.bindPose();
+    skinPositions(mesh.skin.skinningPalette(bindPose), mesh.skin.vertices, mesh.vertices, posed);
+    float bindError = 0.0f;
+    for (size_t i = 0; i < posed.size(); ++i) {
+        bindError = std::max({bindError,
+                              std::abs(posed[i].x - mesh.vertices[i].x),
+                              std::abs(posed[i].y - mesh.vertices[i].y),
+                              std::abs(posed[i].z - mesh.vertices[i].z)});
+    }
+
+    // 30 degrees about y
+    const BoneMatrix turn = BoneMatrix::fromPose(Vector3{0.0f, 0.0f, 0.0f}, Quaternion{0.0f, 0.258819f, 0.0f, 0.965926f});
+    std::vector<BoneMatrix> pose(bindPose.size());
+    for (size_t i = 0; i < pose.size(); ++i)
+        pose[i] = bindPose[i] * turn;
+
+    // Enough passes over the mesh to get a stable time for small characters
+    const int passes = 1000;
+    double time = 0.0;
+    for (int i = 0; i < options.iterations; ++i) {
+        time += measureSeconds([&] {
+            for (int pass = 0; pass < passes; ++pass)
+                skinPositions(mesh.skin.skinningPalette(pose), mesh.skin.vertices, mesh.vertices, posed);
+        });
+    }
+
+    double vertices = static_cast<double>(mesh.vertices.size()) * passes * options.iterations;
+    spdlog::info("{}: {} skinned meshes, posing {} ({} vertices, {} bones)",
+                 options.bundleName,
+                 meshes.size(),
+                 mesh.name,
+                 mesh.vertices.size(),
+                 mesh.skin.bones.size());
+    spdlog::info("skinned vertices: {} unbound, {} with 1 bone, {} with 2, {} with 3, {} with 4",
+                 numVerticesByInfluences[0],
+                 numVerticesByInfluences[1],
+                 numVerticesByInfluences[2],
+                 numVerticesByInfluences[3],
+                 numVerticesByInfluences[4]);
+    spdlog::info("bind pose: max difference {}", bindError);
+    spdlog::info("skinning: {:.1f} M vertices/s", vertices / time / 1e6);
+    return 0;
+}
+
+size_t meshBytes(const Mesh& mesh) {
+    size_t bytes = mesh.vertices.size() * sizeof(Vector3) + mesh.normals.size() * sizeof(Vector3) + mesh.uvs.size() * sizeof(Vector2) +
+                   mesh.indices.size() * (mesh.indices.is32Bit() ? sizeof(uint32_t) : sizeof(uint16_t)) +
+                   mesh.colors.size() * sizeof(uint32_t) + mesh.skin.vertices.size() * sizeof(SkinVertex);
+    for (const auto& extraUvs : mesh.extraUvs)
+        bytes += extraUvs.size() * sizeof(Vector2);
+    for (const auto& extraChannel : mesh.extraChannels)
+        bytes += extraChannel.size() * sizeof(Vector4);
+    for (const MorphFrame& frame : mesh.morphFrames)
+        bytes += frame.memorySize();
+    return bytes;
+}
+
+// Mesh bytes of the scene and an estimate of the bytes the copying build used to copy, computed from the tree: a node's
+// mesh was copied into the node and then once more for every ancestor, each push_back of a child copied its whole subtree
+void sceneBytes(const SceneNode& node, size_t depth, size_t& bytes, size_t& copiedBytes) {
+    if (const Mesh* mesh = node.mesh()) {
+        size_t nodeBytes = meshBytes(*mesh);
+        bytes += nodeBytes;
+        copiedBytes += nodeBytes * (depth + 1);
+    }
+    for (const SceneNode& child : node.children())
+        sceneBytes(child, depth + 1, bytes, copiedBytes);
+}
+
+// Builds every SIR of a level from a warm mesh cache and counts the heap allocations of the build
+int sceneBuildBenchmark(const BenchmarkOptions& options) {
+    SceneIndex sceneIndex = loadSceneIndex(options.bundleName);
+    // Warm up: fills the mesh cache and exports textures
+    loadScenes(sceneIndex);
+
+    AllocationStats allocations;
+    double time = 0.0;
+    size_t bytes = 0;
+    size_t copiedBytes = 0;
+    for (int i = 0; i < options.iterations; ++i) {
+        std::vector<FlatScene> scenes;
+        AllocationStats before = allocationStats();
+        time += measureSeconds([&] { scenes = loadScenes(sceneIndex); });
+        AllocationStats built = allocationStats() - before;
+        allocations.allocations += built.allocations;
+        allocations.bytes += built.bytes;
+
+        bytes = 0;
+        copiedBytes = 0;
+        for (const FlatScene& scene : scenes)
+            sceneBytes(scene.root(), 0, bytes, copiedBytes);
+    }
+
+    const double megabyte = 1024.0 * 1024.0;
+    spdlog::info("{}: {} SIRs, {:.1f} MB of meshes, built in {:.3f}s",
+                 options.bundleName,
+                 sceneIndex.sirs.size(),
+                 bytes / megabyte,
+                 time / options.iterations);
+    spdlog::info("allocations per build: {} ({:.1f} MB)",
+                 allocations.allocations / options.iterations,
+                 allocations.bytes / options.iterations / megabyte);
+    spdlog::info("mesh bytes the copying scene build copied (estimate from the scene tree, not measured): {:.1f} MB",
+                 copiedBytes / megabyte);
+    return 0;
+}
+
+// Pointer tree shaped like the scene graph before FlatScene, kept to compare traversals
+struct TreeNode {
+    std::string name;
+    const Mesh* mesh = nullptr;
+    Vector3 position;
+    std::vector<TreeNode> children;
+};
+
+TreeNode buildTree(const SceneNode& node) {
+    TreeNode treeNode{std::string(node.name()), node.mesh(), node.position(), {}};
+    for (const SceneNode& child : node.children())
+        treeNode.children.push_back(buildTree(child));
+    return treeNode;
+}
+
+// Every traversal sums the same per-node data, so they touch the same amount of memory
+struct TraversalResult {
+    size_t nodes = 0;
+    size_t meshParts = 0;
+    double positionSum = 0.0;
+
+    void add(const Mesh* mesh, const Vector3& position) {
+        ++nodes;
+        meshParts += mesh != nullptr ? mesh->meshParts.size() : 0;
+        positionSum += position.x + position.y + position.z;
+    }
+};
+
+void traverseTree(const TreeNode& node, TraversalResult& result) {
+    result.add(node.mesh, node.position);
+    for (const TreeNode& child : node.children)
+        traverseTree(child, result);
+}
+
+void traverseView(const SceneNode& node, TraversalResult& result) {
+    result.add(node.mesh(), node.position());
+    for (const SceneNode& child : node.children())
+        traverseView(child, result);
+}
+
+void traverseFlat(const FlatScene& scene, TraversalResult& result) {
+    for (NodeIndex i = 0; i < scene.size(); ++i)
+        result.add(scene.mesh(i), scene.position(i));
+}
+
+// Walks every scene of a location as a pointer tree, through the recursive SceneNode view and over the flat arrays
+int sceneTraversalBenchmark(const BenchmarkOptions& options) {
+    SceneIndex sceneIndex = loadSceneIndex(options.bundleName);
+    std::vector<FlatScene> scenes = loadScenes(sceneIndex);
+    std::vector<TreeNode> trees;
+    for (const FlatScene& scene : scenes)
+        trees.push_back(buildTree(scene.root()));
+
+    const int passes = 100;
+    auto measure = [&](auto&& traverse) {
+        TraversalResult result;
+        double time = 0.0;
+        for (int i = 0; i < options.iterations; ++i) {
+            time += measureSeconds([&] {
+                for (int pass = 0; pass < passes; ++pass) {
+                    result = TraversalResult();
+                    for (size_t s = 0; s < scenes.size(); ++s)
+                        traverse(s, result);
+                }
+            });
+        }
+        return std::pair(result, time / (static_cast<double>(options.iterations) * passes));
+    };
+
+    auto [treeResult, treeTime] = measure([&](size_t s, TraversalResult& result) { traverseTree(trees[s], result); });
+    auto [viewResult, viewTime] = measure([&](size_t s, TraversalResult& result) { traverseView(scenes[s].root(), result); });
+    auto [flatResult, flatTime] = measure([&](size_t s, TraversalResult& result) { traverseFlat(scenes[s], result); });
+    if (treeResult.nodes != viewResult.nodes || treeResult.nodes != flatResult.nodes || treeResult.meshParts != flatResult.meshParts)
+        spdlog::error("Traversals visited different nodes");
+
+    const double nanoseconds = 1e9 / static_cast<double>(std::max<size_t>(flatResult.nodes, 1));
+    spdlog::info("{}: {} scenes, {} nodes, {} mesh parts", options.bundleName, scenes.size(), flatResult.nodes, flatResult.meshParts);
+    spdlog::info("pointer tree: {:.2f} ns/node", treeTime * nanoseconds);
+    spdlog::info("recursive view: {:.2f} ns/node", viewTime * nanoseconds);
+    spdlog::info("flat arrays: {:.2f} ns/node", flatTime * nanoseconds);
+    return 0;
+}
+
+// Deterministic tree of `size` nodes up to `maxDepth` levels deep, half of the rotations are left unnormalized
+FlatScene buildSyntheticScene(size_t size, size_t maxDepth) {
+    uint32_t random = 12345;
+    auto next = [&]() {
+        random = random * 1664525u + 1013904223u;
+        return static_cast<float>(random >> 8) / static_cast<float>(1 << 24);
+    };
+
+    FlatScene scene;
+    std::vector<NodeIndex> openNodes;
+    while (scene.size() < size) {
+        if (!openNodes.empty() && (openNodes.size() >= maxDepth || next() < 0.3f)) {
+            scene.endNode(openNodes.back());
+            openNodes.pop_back();
+            continue;
+        }
+
+        const NodeIndex parent = openNodes.empty() ? noNode : openNodes.back();
+        const float length = next() < 0.5f ? 1.0f : 0.5f + next();
+        const Quaternion q{next() - 0.5f, next() - 0.5f, next() - 0.5f, next() - 0.5f};
+        const float factor = length / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        const Quaternion rotation{q.x * factor, q.y * factor, q.z * factor, q.w * factor};
+        const Vector3 position{next() * 10.0f, next() * 10.0f, next() * 10.0f};
+        openNodes.push_back(scene.beginNode(parent, "node", position, rotation, 1.0f));
+    }
+    while (!openNodes.empty()) {
+        scene.endNode(openNodes.back());
+        openNodes.pop_back();
+    }
+    return scene;
+}
+
+void computeWorldRecursive(const SceneNode& node, const Magnum::Matrix4& parent, std::vector<Magnum::Matrix4>& world) {
+    world[node.index()] = parent * node.computeTransformationMatrix();
+    for (const SceneNode& child : node.children())
+        computeWorldRecursive(child, world[node.index()], world);
+}
+
+// World matrices of 100k synthetic nodes, per node through SceneNode and in one batched pass
+int transformsBenchmark(const BenchmarkOptions& options) {
+    const size_t numNodes = 100000;
+    FlatScene scene = buildSyntheticScene(numNodes, 16);
+
+    std::vector<Magnum::Matrix4> world(scene.size());
+    SceneTransforms transforms;
+    double recursiveTime = 0.0;
+    double batchTime = 0.0;
+    for (int i = 0; i < options.iterations; ++i) {
+        recursiveTime += measureSeconds([&] { computeWorldRecursive(scene.root(), Magnum::Matrix4{}, world); });
+        batchTime += measureSeconds([&] { computeTransforms(scene, transforms); });
+    }
+
+    float maxError = 0.0f;
+    for (size_t i = 0; i < scene.size(); ++i) {
+        for (size_t k = 0; k < 16; ++k)
+            maxError = std::max(maxError, std::abs(world[i].data()[k] - transforms.world[i].data()[k]));
+    }
+
+    const double nanoseconds = 1e9 / (static_cast<double>(options.iterations) * scene.size());
+    spdlog::info("{} synthetic nodes, max difference {}", scene.size(), maxError);
+    spdlog::info("recursive computeTransformationMatrix: {:.2f} ns/node", recursiveTime * nanoseconds);
+    spdlog::info("batched computeTransforms: {:.2f} ns/node", batchTime * nanoseconds);
+    return 0;
+}
+
+// The largest location .cdr in the paks, the heaviest shark3d document the tool parses
+std::filesystem::path biggestLocation() {
+    std::filesystem::path result;
+    int64_t biggestSize = -1;
+    for (const auto& path : PackageParser::instance().filenamesWithExtension(".cdr")) {
+        if (path.find("locations") == std::string::npos)
+            continue;
+        auto source = PackageParser::instance().findSource(path);
+        if (source.has_value() && source->size > biggestSize) {
+            biggestSize = source->size;
+            result = path;
+        }
+    }
+    return result;
+}
+
+// Parse time, heap peak and DOM size of the biggest location .cdr
+int sharkParseBenchmark(const BenchmarkOptions& options) {
+    std::filesystem::path path = biggestLocation();
+    if (path.empty()) {
+        spdlog::error("No location .cdr found");
+        return 1;
+    }
+
+    // Warm up: extracts the file and fills the page cache
+    SharkParser warmUp(path);
+
+    double parseTime = 0.0;
+    double freeTime = 0.0;
+    size_t peak = 0;
+    AllocationStats allocations;
+    size_t numNodes = 0;
+    size_t domBytes = 0;
+    for (int i = 0; i < options.iterations; ++i) {
+        std::optional<SharkParser> sharkParser;
+        const size_t live = liveBytes();
+        resetPeakBytes();
+        const AllocationStats before = allocationStats();
+        parseTime += measureSeconds([&] { sharkParser.emplace(path); });
+        allocations = allocationStats() - before;
+        peak = std::max(peak, peakBytes() - live);
+        numNodes = sharkParser->document().numberOfNodes();
+        domBytes = sharkParser->document().memorySize();
+        freeTime += measureSeconds([&] { sharkParser.reset(); });
+    }
+
+    spdlog::info("{}: {} nodes, {} bytes per node", path.string(), numNodes, sizeof(SharkNode));
+    spdlog::info("parse: {:.3f} ms, free: {:.3f} ms", parseTime * 1e3 / options.iterations, freeTime * 1e3 / options.iterations);
+    spdlog::info("{} allocations, heap peak {:.2f} MB, DOM {:.2f} MB",
+                 allocations.allocations,
+                 peak / (1024.0 * 1024.0),
+                 domBytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+// Reading only the SIR list of the biggest location: whole document vs SharkReader skipping the rest
+int sharkIndexBenchmark(const BenchmarkOptions& options) {
+    std::filesystem::path path = biggestLocation();
+    if (path.empty()) {
+        spdlog::error("No location .cdr found");
+        return 1;
+    }
+
+    const char* const childrenPath = "actor_param/child_param/children";
+    SharkParser warmUp(path);
+
+    double fullTime = 0.0;
+    double lazyTime = 0.0;
+    double rereadTime = 0.0;
+    AllocationStats fullAllocations;
+    AllocationStats lazyAllocations;
+    size_t fullNodes = 0;
+    size_t lazyNodes = 0;
+    size_t bytesSkipped = 0;
+    for (int i = 0; i < options.iterations; ++i) {
+        AllocationStats before = allocationStats();
+        fullTime += measureSeconds([&] {
+            SharkParser sharkParser(path);
+            fullNodes = sharkParser.document().numberOfNodes();
+            if (sharkParser.getRoot()->goSub(childrenPath) == nullptr)
+                spdlog::warn("{} has no {}", path.string(), childrenPath);
+        });
+        fullAllocations = allocationStats() - before;
+
+        before = allocationStats();
+        std::optional<SharkReader> reader;
+        std::unique_ptr<SharkDocument> children;
+        lazyTime += measureSeconds([&] {
+            reader.emplace(path);
+            children = reader->read(childrenPath);
+        });
+        lazyAllocations = allocationStats() - before;
+        lazyNodes = children ? children->numberOfNodes() : 0;
+        bytesSkipped = reader->bytesSkipped();
+
+        // Skipped Subs are jumped over now
+        rereadTime += measureSeconds([&] { children = reader->read(childrenPath); });
+    }
+
+    const double milliseconds = 1e3 / options.iterations;
+    spdlog::info("{}: {} bytes skipped", path.string(), bytesSkipped);
+    spdlog::info("full parse: {:.3f} ms, {} nodes, {} allocations", fullTime * milliseconds, fullNodes, fullAllocations.allocations);
+    spdlog::info("SharkReader: {:.3f} ms, {} nodes, {} allocations", lazyTime * milliseconds, lazyNodes, lazyAllocations.allocations);
+    spdlog::info("SharkReader second read: {:.3f} ms", rereadTime * milliseconds);
+    return 0;
+}
+
+// Every SIR of the bundle parsed by parseSharkFiles on one thread and on all cores
+int sharkBatchBenchmark(const BenchmarkOptions& options) {
+    SceneIndex sceneIndex = loadSceneIndex(options.bundleName);
+    std::vector<std::filesystem::path> paths;
+    for (const SirEntry& sir : sceneIndex.sirs)
+        paths.emplace_back(sir.sirPath);
+    if (paths.empty()) {
+        spdlog::error("{} has no SIRs", options.bundleName);
+        return 1;
+    }
+
+    const size_t numCores = std::max(1u, std::thread::hardware_concurrency());
+    double baseline = 0.0;
+    for (size_t numThreads : {size_t(1), numCores}) {
+        ThreadPool pool(numThreads);
+        SharkBatchStats stats;
+        for (int i = 0; i < options.iterations; ++i) {
+            SharkBatch batch = parseSharkFiles(paths, pool);
+            stats.wallSeconds += batch.stats.wallSeconds;
+            stats.parseSeconds += batch.stats.parseSeconds;
+            stats.numBytes = batch.stats.numBytes;
+            stats.numNodes = batch.stats.numNodes;
+            stats.numFailed = batch.stats.numFailed;
+        }
+        if (numThreads == 1)
+            baseline = stats.wallSeconds;
+
+        spdlog::info("{} threads: {} files ({} failed), {} nodes, {:.3f} ms wall, {:.3f} ms parsing, {:.1f} MB/s, x{:.2f}",
+                     numThreads,
+                     paths.size(),
+                     stats.numFailed,
+                     stats.numNodes,
+                     stats.wallSeconds * 1e3 / options.iterations,
+                     stats.parseSeconds * 1e3 / options.iterations,
+                     stats.numBytes * options.iterations / (1024.0 * 1024.0) / stats.wallSeconds,
+                     baseline / stats.wallSeconds);
+    }
+    return 0;
+}
+
+// Opening the biggest location: parsing the shark3d file vs loading its cache file
+int sharkCacheBenchmark(const BenchmarkOptions& options) {
+    std::filesystem::path path = biggestLocation();
+    std::optional<PackageSource> source = PackageParser::instance().findSource(path);
+    if (path.empty() || !source.has_value()) {
+        spdlog::error("No location .cdr found");
+        return 1;
+    }
+
+    const std::filesystem::path cachePath = SharkCache::path(path, {});
+    SharkCache::save(cachePath, *source, *SharkReader(path).readAll());
+
+    double parseTime = 0.0;
+    double loadTime = 0.0;
+    AllocationStats parseAllocations;
+    AllocationStats loadAllocations;
+    size_t numNodes = 0;
+    for (int i = 0; i < options.iterations; ++i) {
+        std::unique_ptr<SharkDocument> parsed;
+        AllocationStats before = allocationStats();
+        parseTime += measureSeconds([&] { parsed = SharkReader(path).readAll(); });
+        parseAllocations = allocationStats() - before;
+
+        std::unique_ptr<SharkDocument> loaded;
+        before = allocationStats();
+        loadTime += measureSeconds([&] { loaded = SharkCache::load(cachePath, *source); });
+        loadAllocations = allocationStats() - before;
+        if (loaded == nullptr || loaded->numberOfNodes() != parsed->numberOfNodes()) {
+            spdlog::error("{} doesn't match {}", cachePath.string(), path.string());
+            return 1;
+        }
+        numNodes = loaded->numberOfNodes();
+    }
+
+    const double milliseconds = 1e3 / options.iterations;
+    spdlog::info("{}: {} nodes, cache {:.2f} MB", path.string(), numNodes, std::filesystem::file_size(cachePath) / (1024.0 * 1024.0));
+    spdlog::info("parse: {:.3f} ms, {} allocations", parseTime * milliseconds, parseAllocations.allocations);
+    spdlog::info("cached: {:.3f} ms, {} allocations", loadTime * milliseconds, loadAllocations.allocations);
+    return 0;
+}
+
+// Streaming the biggest location to JSON and text files
+int sharkDumpBenchmark(const BenchmarkOptions& options) {
+    std::filesystem::path path = biggestLocation();
+    if (path.empty()) {
+        spdlog::error("No location .cdr found");
+        return 1;
+    }
+
+    SharkParser warmUp(path);
+    const double inputSize = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+    const std::filesystem::path outputPath = cacheFolderPath / "shark-dump.tmp";
+    std::filesystem::create_directories(cacheFolderPath);
+    for (auto [format, name] : {std::pair(SharkDumpFormat::Json, "json"), std::pair(SharkDumpFormat::Text, "text")}) {
+        double seconds = 0.0;
+        for (int i = 0; i < options.iterations; ++i) {
+            std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+            seconds += measureSeconds([&] { dumpShark(path, format, out); });
+        }
+        const double outputSize = std::filesystem::file_size(outputPath) / (1024.0 * 1024.0);
+        spdlog::info("{}: {:.3f} ms, {:.2f} MB -> {:.2f} MB, {:.1f} MB/s written",
+                     name,
+                     seconds * 1e3 / options.iterations,
+                     inputSize,
+                     outputSize,
+                     outputSize * options.iterations / seconds);
+    }
+    std::filesystem::remove(outputPath);
+    return 0;
+}
+
+// SIR list the way getSir walked it before it ran a SharkQuery: loadtree entries, recursing into capsules
+std::vector<std::string> walkSir(const SharkNode* children) {
+    if (children == nullptr)
+        return {};
+
+    std::vector<std::string> sirs;
+    for (int i = 0; i < children->count(); i++) {
+        const SharkNode* child = children->at(i);
+        auto type = getEntryValue<std::string_view>(child, "type");
+        if (type.has_value() && *type == "mod_engobj_funcom.loadtree") {
+            auto name = getEntryValue<std::string>(child, "param/tree");
+            if (name.has_value())
+                sirs.emplace_back(*name);
+        }
+
+        if (type.has_value() && *type == "mod_core.capsule") {
+            std::vector<std::string> newSirs = walkSir(child->goSub("param/child_param/children"));
+            std::move(std::begin(newSirs), std::end(newSirs), std::back_inserter(sirs));
+        }
+    }
+    return sirs;
+}
+
+// bpr list the way getBpr walked it before it ran a SharkQuery
+std::vector<std::string> walkBpr(const SharkNode* root) {
+    const SharkNode* node = root->goSub("actor_param/child_param/children");
+    for (int i = 0; node != nullptr && i < node->count(); i++) {
+        auto type = getEntryValue<std::string_view>(node->at(i), "type");
+        if (type.has_value() && *type == "mod_engobj_funcom.locationinit") {
+            auto files = getEntryArray<std::string>(node->at(i), "param/bpr_files");
+            if (files.has_value())
+                return *files;
+        }
+    }
+    return {};
+}
+
+// SIR and bpr lists of the biggest location: the hand-written walkers vs getSir and getBpr, which run compiled selectors
+int sharkQueryBenchmark(const BenchmarkOptions& options) {
+    std::filesystem::path path = biggestLocation();
+    if (path.empty()) {
+        spdlog::error("No location .cdr found");
+        return 1;
+    }
+
+    SharkParser sharkParser(path);
+    const SharkNode* root = sharkParser.getRoot();
+    const SharkNode* children = root->goSub("actor_param/child_param/children");
+
+    std::vector<std::string> walkedSirs;
+    std::vector<std::string> walkedBprs;
+    const double walkerTime = measureSeconds([&] {
+        for (int i = 0; i < options.iterations; ++i) {
+            walkedSirs = walkSir(children);
+            walkedBprs = walkBpr(root);
+        }
+    });
+
+    std::vector<std::string> sirs;
+    std::vector<std::string> bprs;
+    const double queryTime = measureSeconds([&] {
+        for (int i = 0; i < options.iterations; ++i) {
+            sirs = getSir(children);
+            bprs = getBpr(root);
+        }
+    });
+
+    const double milliseconds = 1e3 / options.iterations;
+    spdlog::info("{}: {} nodes", path.string(), sharkParser.document().numberOfNodes());
+    spdlog::info("walkers: {:.3f} ms, {} sirs, {} bprs", walkerTime * milliseconds, walkedSirs.size(), walkedBprs.size());
+    spdlog::info("SharkQuery: {:.3f} ms, {} sirs, {} bprs", queryTime * milliseconds, sirs.size(), bprs.size());
+    if (sirs != walkedSirs || bprs != walkedBprs) {
+        spdlog::error("getSir/getBpr disagree with the walkers");
+        return 1;
+    }
+    return 0;
+}
+
+// String table traffic of the biggest location: every name and string value in file order, replayed against the
+// old int -> std::string map (find, then operator[] copying the string out) and a vector of views into the file
+int sharkStringsBenchmark(const BenchmarkOptions& options) {
+    std::filesystem::path path = biggestLocation();
+    if (path.empty()) {
+        spdlog::error("No location .cdr found");
+        return 1;
+    }
+
+    SharkParser sharkParser(path);
+    const SharkDocument& document = sharkParser.document();
+    // Table indices, numbered by first reference like the file numbers its strings, which introduces them
+    std::vector<uint32_t> references;
+    std::vector<std::string_view> strings;
+    std::vector<uint32_t> indices(document.numberOfAtoms(), SharkDocument::noAtom);
+    auto reference = [&](uint32_t atom) {
+        if (indices[atom] == SharkDocument::noAtom) {
+            indices[atom] = static_cast<uint32_t>(strings.size());
+            strings.push_back(document.string(atom));
+        }
+        references.push_back(indices[atom]);
+    };
+    for (size_t i = 0; i < document.numberOfNodes(); ++i) {
+        const SharkNode* node = document.node(static_cast<uint32_t>(i));
+        reference(node->nameId);
+        if (node->type == SharkNodeType::String)
+            reference(document.atom(*node->value<std::string_view>()));
+        if (node->type == SharkNodeType::ArrayString) {
+            for (std::string_view value : *node->array<std::string_view>())
+                reference(document.atom(value));
+        }
+    }
+
+    size_t mapLength = 0;
+    const double mapTime = measureSeconds([&] {
+        for (int i = 0; i < options.iterations; ++i) {
+            std::unordered_map<int, std::string> table;
+            for (uint32_t reference : references) {
+                const int index = static_cast<int>(reference);
+                if (table.find(index) == table.end())
+                    table[index] = std::string(strings[reference]);
+                std::string string = table[index];
+                mapLength += string.size();
+            }
+        }
+    });
+
+    size_t vectorLength = 0;
+    const double vectorTime = measureSeconds([&] {
+        for (int i = 0; i < options.iterations; ++i) {
+            std::vector<std::string_view> table;
+            for (uint32_t reference : references) {
+                if (reference == table.size())
+                    table.push_back(strings[reference]);
+                std::string_view string = table[reference];
+                vectorLength += string.size();
+            }
+        }
+    });
+
+    const double nanoseconds = 1e9 / (static_cast<double>(options.iterations) * references.size());
+    spdlog::info("{}: {} string references, {} distinct", path.string(), references.size(), strings.size());
+    spdlog::info("unordered_map<int, string>: {:.2f} ns/reference ({} chars)", mapTime * nanoseconds, mapLength);
+    spdlog::info("vector<string_view>: {:.2f} ns/reference ({} chars)", vectorTime * nanoseconds, vectorLength);
+    return 0;
+}
+
+// Shark3d binary of a SIR hierarchy: a root with `numNodes` nodes below it in chains of `depth` levels. Every node
+// has a name, a transl and, above the last level, a child_array holding the next one.
+std::string buildSyntheticSir(size_t numNodes, size_t depth) {
+    std::string out = std::string("shark3d_snake_binary") + '\0' + "2x4" + '\0';
+    auto writeNum = [&](int64_t num) {
+        for (; num >= 0x40; num >>= 7)
+            out += static_cast<char>((num & 0x7f) | 0x80);
+        out += static_cast<char>(num);
+    };
+    std::vector<std::string_view> strings;
+    auto writeString = [&](std::string_view string) {
+        auto it = std::find(strings.begin(), strings.end(), string);
+        if (it != strings.end()) {
+            writeNum(strings.end() - it);
+            return;
+        }
+        writeNum(0);
+        out += string;
+        out += '\0';
+        strings.push_back(string);
+    };
+    auto writeFloat = [&](float value) {
+        const uint32_t bits = std::bit_cast<uint32_t>(value);
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out += static_cast<char>(bits >> shift);
+    };
+    // The Sub of the only element of a child_array follows right after its count
+    auto writeNode = [&](size_t numChildren) {
+        writeNum(numChildren > 0 ? 3 : 2);
+        writeString("name");
+        out += static_cast<char>(0x10);
+        writeString("node");
+        writeString("transl");
+        out += static_cast<char>(8);
+        writeNum(3);
+        for (float value : {1.0f, 2.0f, 3.0f})
+            writeFloat(value);
+        if (numChildren > 0) {
+            writeString("child_array");
+            out += static_cast<char>(0x80);
+            writeNum(static_cast<int64_t>(numChildren));
+        }
+    };
+
+    writeNode(numNodes / depth);
+    for (size_t chain = 0; chain < numNodes / depth; ++chain) {
+        for (size_t level = 0; level < depth; ++level)
+            writeNode(level + 1 < depth ? 1 : 0);
+    }
+    return out;
+}
+
+// Nodes the way SharkReader built them before it kept its own stack: a call per Sub and per ArraySub element.
+// Names stay indices into the string table instead of atoms.
+class RecursiveSharkReader {
+public:
+    explicit RecursiveSharkReader(BinReader& file)
+            : m_file(file) {}
+
+    const std::vector<SharkNode>& read() {
+        m_file.setPosition(0);
+        m_file.readStringLine();
+        m_file.readStringLine();
+        m_nodes.assign(1, SharkNode{SharkNodeType::Sub, 0, 0, 0, nullptr});
+        m_ints.clear();
+        m_floats.clear();
+        m_stringIds.clear();
+        m_strings.clear();
+        uint32_t count = 0;
+        m_nodes[0].offset = readSub(count);
+        m_nodes[0].length = count;
+        return m_nodes;
+    }
+
+    std::string_view string(uint32_t index) const { return m_strings[index]; }
+
+private:
+    uint32_t readString() {
+        const int64_t num = m_file.readSharkNum();
+        if (num == 0)
+            m_strings.push_back(m_file.viewStringLine());
+        return static_cast<uint32_t>(m_strings.size() - (num == 0 ? 1 : num));
+    }
+
+    uint32_t readSub(uint32_t& outCount) {
+        const uint32_t num = static_cast<uint32_t>(m_file.readSharkNum());
+        const uint32_t first = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.resize(first + num);
+        for (uint32_t i = 0; i < num; i++) {
+            const uint32_t nameId = readString();
+            SharkNode node = readValue(nameId, m_file.readByte());
+            m_nodes[first + i] = node;
+        }
+        outCount = num;
+        return first;
+    }
+
+    SharkNode readValue(uint32_t nameId, int attachCode) {
+        SharkNode node{SharkNodeType::Empty, nameId, 0, 0, nullptr};
+        switch (attachCode) {
+        case 0:
+            break;
+        case 1:
+        case 2:
+            node.type = attachCode == 1 ? SharkNodeType::Int : SharkNodeType::ArrayInt;
+            node.offset = static_cast<uint32_t>(m_ints.size());
+            node.length = attachCode == 1 ? 1 : static_cast<uint32_t>(m_file.readSharkNum());
+            for (uint32_t e = 0; e < node.length; e++)
+                m_ints.push_back(m_file.readSharkNum());
+            break;
+        case 4:
+        case 8:
+            node.type = attachCode == 4 ? SharkNodeType::Float : SharkNodeType::ArrayFloat;
+            node.offset = static_cast<uint32_t>(m_floats.size());
+            node.length = attachCode == 4 ? 1 : static_cast<uint32_t>(m_file.readSharkNum());
+            m_floats.resize(node.offset + node.length);
+            m_file.readEndianFloats(m_floats.data() + node.offset, node.length);
+            break;
+        case 0x10:
+        case 0x20:
+            node.type = attachCode == 0x10 ? SharkNodeType::String : SharkNodeType::ArrayString;
+            node.offset = static_cast<uint32_t>(m_stringIds.size());
+            node.length = attachCode == 0x10 ? 1 : static_cast<uint32_t>(m_file.readSharkNum());
+            for (uint32_t e = 0; e < node.length; e++)
+                m_stringIds.push_back(readString());
+            break;
+        case 0x40:
+            node.type = SharkNodeType::Sub;
+            node.offset = readSub(node.length);
+            break;
+        case 0x80:
+            node.type = SharkNodeType::ArraySub;
+            node.length = static_cast<uint32_t>(m_file.readSharkNum());
+            node.offset = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.resize(node.offset + node.length);
+            for (uint32_t e = 0; e < node.length; e++) {
+                SharkNode element{SharkNodeType::Sub, nameId, 0, 0, nullptr};
+                element.offset = readSub(element.length);
+                m_nodes[node.offset + e] = element;
+            }
+            break;
+        default:
+            spdlog::error("Unrecognized code in shark3d binary!");
+            break;
+        }
+        return node;
+    }
+
+    BinReader& m_file;
+    std::vector<SharkNode> m_nodes;
+    std::vector<int64_t> m_ints;
+    std::vector<float> m_floats;
+    std::vector<uint32_t> m_stringIds;
+    std::vector<std::string_view> m_strings;
+};
+
+// Counts what SharkReader::visit streams, dumpShark writes the same events
+class SubCounter : public SharkVisitor {
+public:
+    void beginSub(std::string_view) override { ++numSubs; }
+    void endSub() override { ++numEnded; }
+    void beginArray(std::string_view, SharkNodeType, size_t) override {}
+    void endArray() override {}
+
+    void empty(std::string_view) override {}
+    void value(std::string_view, int64_t) override {}
+    void value(std::string_view, float) override {}
+    void value(std::string_view name, std::string_view) override { numNames += name == "name"; }
+
+    size_t numSubs = 0;
+    size_t numEnded = 0;
+    size_t numNames = 0;
+};
+
+// The scene of buildSyntheticSir in pre-order: the root, then every chain with its levels one below the other
+bool isSyntheticScene(const FlatScene& scene, size_t numNodes, size_t depth) {
+    if (scene.size() != numNodes + 1 || scene.parent(0) != noNode)
+        return false;
+    for (NodeIndex index = 1; index < scene.size(); ++index) {
+        const NodeIndex expectedParent = (index - 1) % depth == 0 ? 0 : index - 1;
+        if (scene.parent(index) != expectedParent || scene.name(index) != "node")
+            return false;
+    }
+    return true;
+}
+
+// 100k-node synthetic SIR hierarchies from flat to a single chain: SharkReader, SharkQuery, SharkReader::visit and
+// loadHierarchy with their explicit stacks vs the recursive reader, which only gets the depths the stack of the thread
+// survives. Every depth is checked against the hierarchy that was written.
+int sharkDeepBenchmark(const BenchmarkOptions& options) {
+    const size_t numNodes = 100000;
+    const size_t maxRecursiveDepth = 1000;
+    const std::filesystem::path path = cacheFolderPath / "shark-deep.tmp";
+    std::filesystem::create_directories(cacheFolderPath);
+
+    SharkQuery query;
+    query.add("**/name");
+    for (size_t depth : {size_t(1), size_t(100), maxRecursiveDepth, numNodes}) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << buildSyntheticSir(numNodes, depth);
+        }
+        auto file = std::make_shared<BinReaderMmap>(path);
+        SharkReader reader(file);
+
+        std::unique_ptr<SharkDocument> document;
+        double readTime = 0.0;
+        for (int i = 0; i < options.iterations; ++i) {
+            document.reset();
+            readTime += measureSeconds([&] { document = reader.readAll(); });
+        }
+
+        size_t numNames = 0;
+        const double queryTime = measureSeconds([&] {
+            for (int i = 0; i < options.iterations; ++i)
+                numNames = query.run(document->root()).front().size();
+        });
+
+        SubCounter counter;
+        bool isVisited = false;
+        const double visitTime = measureSeconds([&] {
+            for (int i = 0; i < options.iterations; ++i) {
+                counter = SubCounter{};
+                isVisited = reader.visit(counter);
+            }
+        });
+
+        // Leaves stand in for the meshes, so no subtree is dropped
+        FlatScene scene;
+        const SharkPath childArray(*document, "child_array");
+        auto loadNode = [&](const SharkNode* node, NodeIndex) { return node->goSub(childArray) == nullptr; };
+        const double sceneTime = measureSeconds([&] {
+            for (int i = 0; i < options.iterations; ++i) {
+                scene = FlatScene{};
+                loadHierarchy(document->root(), scene, loadNode);
+            }
+        });
+
+        const double nanoseconds = 1e9 / (static_cast<double>(options.iterations) * document->numberOfNodes());
+        spdlog::info("depth {}: {} nodes, {} names, {} scene nodes", depth, document->numberOfNodes(), numNames, scene.size());
+        spdlog::info("  SharkReader: {:.2f} ns/node, SharkQuery: {:.2f} ns/node, visit: {:.2f} ns/node, loadHierarchy: {:.2f} ns/node",
+                     readTime * nanoseconds,
+                     queryTime * nanoseconds,
+                     visitTime * nanoseconds,
+                     sceneTime * nanoseconds);
+        if (numNames != numNodes + 1) {
+            spdlog::error("depth {}: SharkQuery found {} names instead of {}", depth, numNames, numNodes + 1);
+            return 1;
+        }
+        if (!isVisited || counter.numSubs != numNodes + 1 || counter.numEnded != counter.numSubs || counter.numNames != numNodes + 1) {
+            spdlog::error("depth {}: visit streamed {} Subs, {} ended, {} names",
+                          depth,
+                          counter.numSubs,
+                          counter.numEnded,
+                          counter.numNames);
+            return 1;
+        }
+        if (!isSyntheticScene(scene, numNodes, depth)) {
+            spdlog::error("depth {}: loadHierarchy built a different scene", depth);
+            return 1;
+        }
+        if (depth > maxRecursiveDepth)
+            continue;
+
+        BinReaderMmap recursiveFile(path);
+        RecursiveSharkReader recursiveReader(recursiveFile);
+        const std::vector<SharkNode>* nodes = nullptr;
+        const double recursiveTime = measureSeconds([&] {
+            for (int i = 0; i < options.iterations; ++i)
+                nodes = &recursiveReader.read();
+        });
+        for (uint32_t i = 0; i < nodes->size(); ++i) {
+            const SharkNode& expected = (*nodes)[i];
+            const SharkNode* node = document->node(i);
+            const bool isSame = node->type == expected.type && node->offset == expected.offset && node->length == expected.length &&
+                                (i == 0 || node->name() == recursiveReader.string(expected.nameId));
+            if (nodes->size() != document->numberOfNodes() || !isSame) {
+                spdlog::error("Node {} differs from the recursive reader", i);
+                return 1;
+            }
+        }
+        spdlog::info("  recursive: {:.2f} ns/node", recursiveTime * nanoseconds);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
+
+// Child lookup the way goSub did before atoms: the path split into strings on every call, names compared as strings
+const SharkNode* goSubByString(const SharkNode* node, const std::string& path) {
+    for (const std::string& name : Utils::splitString(path, '/')) {
+        if (node->type != SharkNodeType::Sub)
+            return nullptr;
+        const SharkNode* next = nullptr;
+        for (uint32_t i = 0; i < node->length && next == nullptr; ++i) {
+            const SharkNode* child = node->document->node(node->offset + i);
+            if (std::string(child->name()) == name)
+                next = child;
+        }
+        if (next == nullptr)
+            return nullptr;
+        node = next;
+    }
+    return node;
+}
+
+const char* const hierarchyEntries[] = {"transl", "quat", "name", "model", "shader", "child_array"};
+
+// The lookups loadHierarchy does on every node, returns the number of nodes visited
+template <typename Lookup>
+size_t queryHierarchy(const SharkNode* node, const Lookup& lookup, size_t& numFound) {
+    for (int entry = 0; entry < 5; ++entry)
+        numFound += lookup(node, entry) != nullptr;
+
+    size_t numNodes = 1;
+    const SharkNode* group = lookup(node, 5);
+    for (size_t i = 0; group != nullptr && i < group->count(); ++i)
+        numNodes += queryHierarchy(group->at(static_cast<int>(i)), lookup, numFound);
+    return numNodes;
+}
+
+// loadHierarchy lookups over every SIR of a location: split string paths, string_view paths and precompiled SharkPaths
+int sharkLookupBenchmark(const BenchmarkOptions& options) {
+    SceneIndex sceneIndex = loadSceneIndex(options.bundleName);
+    std::vector<std::unique_ptr<SharkParser>> documents;
+    for (const auto& sir : sceneIndex.sirs)
+        documents.push_back(std::make_unique<SharkParser>(sir.sirPath));
+
+    size_t numNodes = 0;
+    size_t found[3] = {};
+    double times[3] = {};
+    for (int i = 0; i < options.iterations; ++i) {
+        for (const auto& document : documents) {
+            const SharkNode* root = document->getRoot()->goSub("data/root");
+            if (root == nullptr)
+                continue;
+
+            std::vector<SharkPath> paths;
+            for (const char* entry : hierarchyEntries)
+                paths.emplace_back(document->document(), entry);
+
+            size_t count = 0;
+            times[0] += measureSeconds([&] {
+                auto lookup = [](const SharkNode* node, int entry) { return goSubByString(node, hierarchyEntries[entry]); };
+                count = queryHierarchy(root, lookup, found[0]);
+            });
+            times[1] += measureSeconds([&] {
+                auto lookup = [](const SharkNode* node, int entry) { return node->goSub(hierarchyEntries[entry]); };
+                queryHierarchy(root, lookup, found[1]);
+            });
+            times[2] += measureSeconds([&] {
+                auto lookup = [&paths](const SharkNode* node, int entry) { return node->goSub(paths[entry]); };
+                queryHierarchy(root, lookup, found[2]);
+            });
+            numNodes += count;
+        }
+    }
+
+    const double nanoseconds = 1e9 / std::max<size_t>(numNodes, 1);
+    spdlog::info("{}: {} SIRs, {} hierarchy nodes, {} / {} / {} entries found",
+                 options.bundleName,
+                 documents.size(),
+                 numNodes / options.iterations,
+                 found[0],
+                 found[1],
+                 found[2]);
+    spdlog::info("split string paths: {:.1f} ns/node", times[0] * nanoseconds);
+    spdlog::info("atom lookup per call: {:.1f} ns/node", times[1] * nanoseconds);
+    spdlog::info("precompiled SharkPath: {:.1f} ns/node", times[2] * nanoseconds);
+    return 0;
+}
+
+const std::map<std::string, std::function<int(const BenchmarkOptions&)>> benchmarks = {
+    {"mesh-cache", meshCacheBenchmark},
+    {"mesh-info", meshInfoBenchmark},
+    {"scene-build", sceneBuildBenchmark},
+    {"scene-traversal", sceneTraversalBenchmark},
+    {"shark-batch", sharkBatchBenchmark},
+    {"shark-cache", sharkCacheBenchmark},
+    {"shark-deep", sharkDeepBenchmark},
+    {"shark-dump", sharkDumpBenchmark},
+    {"shark-index", sharkIndexBenchmark},
+    {"shark-lookup", sharkLookupBenchmark},
+    {"shark-parse", sharkParseBenchmark},
+    {"shark-query", sharkQueryBenchmark},
+    {"shark-strings", sharkStringsBenchmark},
+    {"skinning", skinningBenchmark},
+    {"transforms", transformsBenchmark},
+    {"vertex-decode", vertexDecodeBenchmark},
+};
+
+} // namespace
+
+int runBenchmark(const std::string& name, const BenchmarkOptions& options) {
+    auto it = benchmarks.find(name);
+    if (it == benchmarks.end()) {
+        std::string names;
+        for (const auto& benchmark : benchmarks)
+            names += " " + benchmark.first;
+        spdlog::error("Unknown benchmark '{}', available:{}", name, names);
+        return 1;
+    }
+
+    spdlog::info("Running benchmark '{}' on {}", name, options.bundleName);
+    return it->second(options);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+struct BenchmarkOptions {
+    std::string bundleName;
+    int iterations = 3;
+};
+
+// Headless benchmarks, started with --benchmark <name>. Returns the process exit code.
+int runBenchmark(const std::string& name, const BenchmarkOptions& options);
@@ -0,0 +1,66 @@
+#include "ExportManifest.h"
+
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+
+namespace {
+
+// Bump when the manifest layout changes, every SIR is exported again
+const std::string manifestHeader = "DreamfallTLJ export manifest 1";
+
+} // namespace
+
+ExportManifest::ExportManifest(std::filesystem::path path)
+        : m_path(std::move(path)) {
+    std::ifstream in(m_path);
+    if (!in.is_open())
+        return;
+
+    std::string header;
+    if (!std::getline(in, header) || header != manifestHeader) {
+        spdlog::info("Export manifest {} is outdated, every SIR will be exported", m_path.string());
+        return;
+    }
+
+    std::string sirName;
+    uint64_t inputHash = 0;
+    while (in >> sirName >> std::hex >> inputHash >> std::dec)
+        m_entries[sirName] = inputHash;
+}
+
+bool ExportManifest::isUpToDate(const std::string& sirName, uint64_t inputHash) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_entries.find(sirName);
+    return it != m_entries.end() && it->second == inputHash;
+}
+
+void ExportManifest::set(const std::string& sirName, uint64_t inputHash) {
+    std::lock_guard lock(m_mutex);
+    m_entries[sirName] = inputHash;
+}
+
+void ExportManifest::remove(const std::string& sirName) {
+    std::lock_guard lock(m_mutex);
+    m_entries.erase(sirName);
+}
+
+bool ExportManifest::save() const {
+    std::lock_guard lock(m_mutex);
+    std::filesystem::create_directories(m_path.parent_path());
+    std::ofstream out(m_path, std::ios::trunc);
+    if (!out.is_open()) {
+        spdlog::error("Export manifest {} can't be written", m_path.string());
+        return false;
+    }
+
+    out << manifestHeader << '\n';
+    for (const auto& [sirName, inputHash] : m_entries)
+        out << sirName << ' ' << std::hex << inputHash << std::dec << '\n';
+    return true;
+}
+
+size_t ExportManifest::size() const {
+    std::lock_guard lock(m_mutex);
+    return m_entries.size();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Hash of the inputs every SIR of an export folder was written from, kept next to the FBX files.
+// A SIR whose inputs hash the same as last run and whose FBX still exists is skipped.
+class ExportManifest {
+public:
+    // Loads the manifest if there is one, a missing or outdated manifest is empty
+    explicit ExportManifest(std::filesystem::path path);
+
+    bool isUpToDate(const std::string& sirName, uint64_t inputHash) const;
+
+    // Thread-safe, called by the workers as SIRs finish
+    void set(const std::string& sirName, uint64_t inputHash);
+    void remove(const std::string& sirName);
+
+    bool save() const;
+
+    size_t size() const;
+
+private:
+    std::filesystem::path m_path;
+    std::map<std::string, uint64_t> m_entries;
+    mutable std::mutex m_mutex;
+};
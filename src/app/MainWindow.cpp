@@ -4,9 +4,11 @@
 #include "MeshExporter.h"
 #include "View.h"
 
+#include <parser/Bundle.h>
 #include <parser/SceneIndex.h>
 #include <parser/SceneParser.h>
 #include <parser/SharkParser.h>
+#include <parser/ThreadPool.h>
 
 #pragma warning(push)
 #pragma warning(disable : 5054)
@@ -19,6 +21,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include <thread>
+
 MainWindow::MainWindow(Magnum::Platform::GLContext& context)
         : m_glView(new View(context, this))
         , m_list(new QListWidget(this))
@@ -73,23 +77,23 @@ void MainWindow::onItemChanged(QListWidgetItem* item) {
 }
 
 void MainWindow::doExportAsSingleMesh() {
-    std::vector<parser::SceneNode> parsedSceneNodes = loadedMeshes();
-    if (parsedSceneNodes.empty())
+    std::vector<parser::FlatScene> parsedScenes = loadedMeshes();
+    if (parsedScenes.empty())
         return;
 
     std::filesystem::path path = std::filesystem::path("meshes") / (m_sceneIndex->bundleName + ".fbx");
-    auto isExtracted = exportScene(parsedSceneNodes, path, ExportMode::Single);
+    auto isExtracted = exportScene(parsedScenes, path, ExportMode::Single);
     if (!isExtracted)
         spdlog::error("Export single mesh failed");
 }
 
 void MainWindow::doExportAsMultipleMeshes() {
-    std::vector<parser::SceneNode> parsedSceneNodes = loadedMeshes();
-    if (parsedSceneNodes.empty())
+    std::vector<parser::FlatScene> parsedScenes = loadedMeshes();
+    if (parsedScenes.empty())
         return;
 
     std::filesystem::path path = std::filesystem::path("meshes") / m_sceneIndex->bundleName;
-    auto isExtracted = exportScene(parsedSceneNodes, path, ExportMode::Multiple);
+    auto isExtracted = exportScene(parsedScenes, path, ExportMode::Multiple);
     if (!isExtracted)
         spdlog::error("Export multiple meshes failed");
 }
@@ -100,9 +104,11 @@ void MainWindow::showSelectBundleWindow() {
 
 void MainWindow::loadBundle(const std::string& bundleName) {
     std::filesystem::path sceneSDRPath = "data/generated/locations/" + bundleName + ".cdr";
-    parser::SharkParser sceneSharkParser(sceneSDRPath);
-    m_sceneIndex = std::make_unique<parser::SceneIndex>(sceneSharkParser.parseScene(bundleName));
-    m_glView->setSceneIndex(m_sceneIndex.get());
+    // The SIR hierarchies are parsed on every core here, fillList then only loads their meshes
+    parser::ThreadPool pool(std::thread::hardware_concurrency());
+    m_sceneIndex = std::make_unique<parser::SceneIndex>(parser::parseSceneIndex(sceneSDRPath, bundleName, &pool));
+    m_bundle = std::make_unique<parser::Bundle>(bundleName);
+    m_glView->setSceneIndex(m_sceneIndex.get(), m_bundle.get());
     fillList();
 }
 
@@ -122,16 +128,18 @@ void MainWindow::fillList() {
             item->setFlags(Qt::NoItemFlags);
         item->setCheckState(Qt::Unchecked);
     }
+
+    // Every SIR was parsed once above, later loads find their meshes in the cache
+    m_bundle->flush();
 }
 
 bool MainWindow::canLoadItem(size_t sirIndex) {
-    std::unique_ptr<parser::SceneParser> scene =
-        std::make_unique<parser::SceneParser>(m_sceneIndex->sirs[sirIndex], m_sceneIndex->bundleName);
-    return scene->sceneRoot.has_value();
+    std::unique_ptr<parser::SceneParser> scene = std::make_unique<parser::SceneParser>(m_sceneIndex->sirs[sirIndex], *m_bundle);
+    return scene->flatScene.has_value();
 }
 
-std::vector<parser::SceneNode> MainWindow::loadedMeshes() {
-    std::vector<parser::SceneNode> parsedSceneNodes;
+std::vector<parser::FlatScene> MainWindow::loadedMeshes() {
+    std::vector<parser::FlatScene> parsedScenes;
     for (int sirIndex = 0; sirIndex < m_list->count(); ++sirIndex) {
         QListWidgetItem* item = m_list->item(sirIndex);
         if (!item->checkState())
@@ -140,15 +148,15 @@ std::vector<parser::SceneNode> MainWindow::loadedMeshes() {
         auto sir = m_sceneIndex->sirs[sirIndex];
         spdlog::info(item->text().toStdString());
 
-        parser::SceneParser scene(sir, m_sceneIndex->bundleName);
+        parser::SceneParser scene(sir, *m_bundle);
 
-        if (scene.sceneRoot.has_value())
+        if (scene.flatScene.has_value())
             spdlog::info("SIR: '{}' parsed", sir.filename);
         else
             spdlog::warn("SIR: '{}' not parsed", sir.filename);
 
-        if (scene.sceneRoot.has_value())
-            parsedSceneNodes.push_back(*scene.sceneRoot);
+        if (scene.flatScene.has_value())
+            parsedScenes.push_back(std::move(*scene.flatScene));
     }
-    return parsedSceneNodes;
+    return parsedScenes;
 }
\ No newline at end of file
@@ -9,8 +9,9 @@
 #pragma warning(pop)
 
 namespace parser {
+class Bundle;
 struct SceneIndex;
-struct SceneNode;
+class FlatScene;
 } // namespace parser
 class View;
 class BundleListWindow;
@@ -37,7 +38,7 @@ public:
 private:
     void fillList();
     bool canLoadItem(size_t sirIndex);
-    std::vector<parser::SceneNode> loadedMeshes();
+    std::vector<parser::FlatScene> loadedMeshes();
 
     QListWidget* m_list;
     View* m_glView;
@@ -45,4 +46,5 @@ private:
     BundleListWindow* m_bundleListWindow;
 
     std::unique_ptr<parser::SceneIndex> m_sceneIndex;
+    std::unique_ptr<parser::Bundle> m_bundle; // shared by the SIRs of the scene index
 };
\ No newline at end of file
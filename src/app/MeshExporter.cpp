@@ -59,7 +59,8 @@ void prepareScene(FbxManager* fbxManager,
         return material;
     };
 
-    FbxNode* fbxMeshNode = FbxNode::Create(fbxManager, parsedSceneNode.name.c_str());
+    const std::string nodeName(parsedSceneNode.name());
+    FbxNode* fbxMeshNode = FbxNode::Create(fbxManager, nodeName.c_str());
     fbxSceneNode->AddChild(fbxMeshNode);
 
     const double rad2Deg = 57.2958;
@@ -74,10 +75,10 @@ void prepareScene(FbxManager* fbxManager,
         fbxMeshNode->LclScaling.Set(FbxVector4(50, 50, 50));
     }
 
-    if (parsedSceneNode.mesh.has_value() && !parsedSceneNode.mesh->meshParts.empty() &&
-        !parsedSceneNode.mesh->meshParts[0].textures.empty()) {
-        const auto& mesh = *parsedSceneNode.mesh;
-        FbxMesh* fbxMesh = FbxMesh::Create(fbxManager, parsedSceneNode.name.c_str());
+    const parser::Mesh* parsedMesh = parsedSceneNode.mesh();
+    if (parsedMesh != nullptr && !parsedMesh->meshParts.empty() && !parsedMesh->meshParts[0].textures.empty()) {
+        const auto& mesh = *parsedMesh;
+        FbxMesh* fbxMesh = FbxMesh::Create(fbxManager, nodeName.c_str());
         fbxMesh->InitControlPoints(mesh.vertices.size());
         FbxVector4* controlPoints = fbxMesh->GetControlPoints();
 
@@ -121,6 +122,29 @@ void prepareScene(FbxManager* fbxManager,
             }
         }
 
+        if (!mesh.colors.empty()) {
+            FbxGeometryElementVertexColor* colorElement = fbxMesh->CreateElementVertexColor();
+            colorElement->SetMappingMode(FbxLayerElement::eByControlPoint);
+            colorElement->SetReferenceMode(FbxLayerElement::eDirect);
+
+            for (uint32_t color : mesh.colors) {
+                colorElement->GetDirectArray().Add(FbxColor(((color >> 16) & 0xFF) / 255.0,
+                                                            ((color >> 8) & 0xFF) / 255.0,
+                                                            (color & 0xFF) / 255.0,
+                                                            ((color >> 24) & 0xFF) / 255.0));
+            }
+        }
+
+        for (size_t uvSet = 0; uvSet < mesh.extraUvs.size(); ++uvSet) {
+            const std::string uvSetName = "UV" + std::to_string(uvSet + 1);
+            FbxGeometryElementUV* uvElement = fbxMesh->CreateElementUV(uvSetName.c_str());
+            uvElement->SetMappingMode(FbxLayerElement::eByControlPoint);
+            uvElement->SetReferenceMode(FbxLayerElement::eDirect);
+
+            for (const parser::Vector2& uv : mesh.extraUvs[uvSet])
+                uvElement->GetDirectArray().Add(FbxVector2(uv.x, uv.y));
+        }
+
         for (size_t partIndex = 0; partIndex < mesh.meshParts.size(); ++partIndex) {
             const auto& meshPart = mesh.meshParts[partIndex];
             FbxLayer* layer = fbxMesh->GetLayer(partIndex);
@@ -157,12 +181,32 @@ void prepareScene(FbxManager* fbxManager,
             }
         }
 
+        // Morph frames become blend shape channels, expanded one frame at a time from the delta stream
+        if (!mesh.morphFrames.empty()) {
+            FbxBlendShape* blendShape = FbxBlendShape::Create(fbxManager, (nodeName + "_frames").c_str());
+            for (size_t frameIndex = 0; frameIndex < mesh.morphFrames.size(); ++frameIndex) {
+                const parser::MorphFrame& frame = mesh.morphFrames[frameIndex];
+                const std::string frameName = nodeName + "_frame" + std::to_string(frameIndex + 1);
+                FbxBlendShapeChannel* channel = FbxBlendShapeChannel::Create(fbxManager, frameName.c_str());
+                FbxShape* shape = FbxShape::Create(fbxManager, frameName.c_str());
+                shape->InitControlPoints(mesh.vertices.size());
+                FbxVector4* shapePoints = shape->GetControlPoints();
+                std::vector<parser::Vector3> positions = frame.positions(mesh.vertices);
+                for (size_t i = 0; i < positions.size(); ++i)
+                    shapePoints[i] = FbxVector4(positions[i].x, positions[i].y, positions[i].z);
+
+                channel->AddTargetShape(shape);
+                blendShape->AddBlendShapeChannel(channel);
+            }
+            fbxMesh->AddDeformer(blendShape);
+        }
+
         fbxMeshNode->SetNodeAttribute(fbxMesh);
         fbxMeshNode->SetShadingMode(FbxNode::eTextureShading);
     }
 
-    if (parsedSceneNode.light.has_value()) {
-        const auto& light = *parsedSceneNode.light;
+    if (const parser::PointLight* parsedLight = parsedSceneNode.light()) {
+        const auto& light = *parsedLight;
         FbxNode* fbxLightNode = FbxNode::Create(fbxScene, "PointLightNode");
         fbxMeshNode->AddChild(fbxLightNode);
 
@@ -173,10 +217,8 @@ void prepareScene(FbxManager* fbxManager,
         fbxLight->Intensity.Set(light.intencity);
     }
 
-    if (!parsedSceneNode.children.empty()) {
-        for (size_t i = 0; i < parsedSceneNode.children.size(); ++i)
-            prepareScene(fbxManager, fbxScene, fbxMeshNode, parsedSceneNode.children[i]);
-    }
+    for (const parser::SceneNode& child : parsedSceneNode.children())
+        prepareScene(fbxManager, fbxScene, fbxMeshNode, child);
 }
 
 bool saveScene(FbxManager* fbxManager, FbxScene* fbxScene, const std::string& outputPath, int fileFormat) {
@@ -193,8 +235,8 @@ bool saveScene(FbxManager* fbxManager, FbxScene* fbxScene, const std::string& ou
     return status;
 }
 
-bool exportScene(const std::vector<parser::SceneNode>& parsedSceneNodes, const std::filesystem::path& outputPath, ExportMode exportMode) {
-    if (parsedSceneNodes.empty())
+bool exportScene(const std::vector<parser::FlatScene>& parsedScenes, const std::filesystem::path& outputPath, ExportMode exportMode) {
+    if (parsedScenes.empty())
         return false;
 
     FbxManager* fbxManager = FbxManager::Create();
@@ -226,18 +268,19 @@ bool exportScene(const std::vector<parser::SceneNode>& parsedSceneNodes, const s
     }
 
     if (exportMode == ExportMode::Single) {
-        for (const auto& parsedSceneRoot : parsedSceneNodes)
-            prepareScene(fbxManager, fbxScene, fbxScene->GetRootNode(), parsedSceneRoot, true);
+        for (const auto& parsedScene : parsedScenes)
+            prepareScene(fbxManager, fbxScene, fbxScene->GetRootNode(), parsedScene.root(), true);
 
         std::filesystem::create_directories(outputPath.parent_path());
         saveScene(fbxManager, fbxScene, outputPath.string().c_str(), -1);
     }
     else if (exportMode == ExportMode::Multiple) {
         std::filesystem::create_directories(outputPath);
-        for (const auto& parsedSceneRoot : parsedSceneNodes) {
+        for (const auto& parsedScene : parsedScenes) {
+            const parser::SceneNode parsedSceneRoot = parsedScene.root();
             prepareScene(fbxManager, fbxScene, fbxScene->GetRootNode(), parsedSceneRoot, true);
 
-            auto meshPath = outputPath / (parsedSceneRoot.name + ".fbx");
+            auto meshPath = outputPath / (std::string(parsedSceneRoot.name()) + ".fbx");
             saveScene(fbxManager, fbxScene, meshPath.string().c_str(), -1);
         }
     }
@@ -3,7 +3,7 @@
 #include <filesystem>
 
 namespace parser {
-struct SceneNode;
+class FlatScene;
 }
 
 enum class ExportMode
@@ -12,4 +12,4 @@ enum class ExportMode
     Multiple
 };
 
-bool exportScene(const std::vector<parser::SceneNode>& parsedSceneNodes, const std::filesystem::path& outputPath, ExportMode exportMode);
+bool exportScene(const std::vector<parser::FlatScene>& parsedScenes, const std::filesystem::path& outputPath, ExportMode exportMode);
@@ -25,13 +25,13 @@ void View::unload(size_t sirIndex) {
     m_meshToUnloading.push_back(sirIndex);
 }
 
-void View::setSceneIndex(parser::SceneIndex* sceneIndex) {
+void View::setSceneIndex(parser::SceneIndex* sceneIndex, parser::Bundle* bundle) {
     if (m_sceneIndex) {
         for (size_t i = 0; i < m_sceneIndex->sirs.size(); ++i)
             m_meshToUnloading.push_back(i);
     }
     m_sceneIndex = sceneIndex;
-    m_viewScene->setSceneIndex(sceneIndex);
+    m_viewScene->setSceneIndex(sceneIndex, bundle);
 }
 
 void View::initializeGL() {
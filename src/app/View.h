@@ -12,8 +12,9 @@
 #pragma warning(pop)
 
 namespace parser {
+class Bundle;
 struct SceneIndex;
-}
+} // namespace parser
 class ViewScene;
 
 class View : public QOpenGLWidget {
@@ -24,7 +25,7 @@ public:
     void load(size_t sirIndex);
     void unload(size_t sirIndex);
 
-    void setSceneIndex(parser::SceneIndex* sceneIndex);
+    void setSceneIndex(parser::SceneIndex* sceneIndex, parser::Bundle* bundle);
 
 private:
     void initializeGL() override;
@@ -5,6 +5,7 @@
 
 #include <parser/SceneIndex.h>
 #include <parser/SceneParser.h>
+#include <parser/SceneTransforms.h>
 
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/TextureFormat.h>
@@ -77,7 +78,8 @@ Trade::MeshData3D createMeshData(const parser::Mesh& mesh, size_t meshPartIndex)
     }
 
     for (size_t i = meshPart.vertexInterval.first; i < meshPart.vertexInterval.second; ++i) {
-        const auto& uv = mesh.uvs[i];
+        // Parts without UVs sample the texture at (0, 0), like the padding of meshes that mix both
+        const parser::Vector2 uv = mesh.uvs.empty() ? parser::Vector2{} : mesh.uvs[i];
         textureCoords2D[0].emplace_back(uv.x, uv.y);
     }
 
@@ -119,17 +121,18 @@ void ViewScene::load(size_t sirIndex) {
     if (m_drawables.contains(sirIndex))
         return;
 
-    assert(m_sceneIndex);
-    std::unique_ptr<parser::SceneParser> scene =
-        std::make_unique<parser::SceneParser>(m_sceneIndex->sirs[sirIndex], m_sceneIndex->bundleName);
-    if (!scene->sceneRoot.has_value())
+    assert(m_sceneIndex && m_bundle);
+    std::unique_ptr<parser::SceneParser> scene = std::make_unique<parser::SceneParser>(m_sceneIndex->sirs[sirIndex], *m_bundle);
+    if (!scene->flatScene.has_value())
         return;
 
     DrawableData drawableData;
-    drawableData.meshes = Containers::Array<Containers::Optional<GL::Mesh>>{scene->sceneRoot->numberOfMeshes()};
-    drawableData.textures = Containers::Array<Containers::Optional<Magnum::GL::Texture2D>>{scene->sceneRoot->numberOfMeshes()};
+    drawableData.meshes = Containers::Array<Containers::Optional<GL::Mesh>>{scene->flatScene->numberOfMeshes()};
+    drawableData.textures = Containers::Array<Containers::Optional<Magnum::GL::Texture2D>>{scene->flatScene->numberOfMeshes()};
 
-    setupScene(*scene->sceneRoot, drawableData);
+    parser::SceneTransforms transforms;
+    parser::computeTransforms(*scene->flatScene, transforms);
+    setupScene(scene->flatScene->root(), transforms, drawableData);
     m_drawables[sirIndex] = std::move(drawableData);
 }
 
@@ -138,8 +141,9 @@ void ViewScene::unload(size_t sirIndex) {
         m_drawables.erase(sirIndex);
 }
 
-void ViewScene::setSceneIndex(parser::SceneIndex* sceneIndex) {
+void ViewScene::setSceneIndex(parser::SceneIndex* sceneIndex, parser::Bundle* bundle) {
     m_sceneIndex = sceneIndex;
+    m_bundle = bundle;
 }
 
 void ViewScene::draw() {
@@ -183,18 +187,22 @@ void ViewScene::updateCameraTransform() {
     m_cameraObject.setTransformation(transfromation);
 }
 
-void ViewScene::setupScene(const parser::SceneNode& node, DrawableData& drawableData) {
+void ViewScene::setupScene(const parser::SceneNode& node, const parser::SceneTransforms& transforms, DrawableData& drawableData) {
     size_t meshIndex = 0;
-    setupScene(node, m_manipulator, meshIndex, drawableData);
+    setupScene(node, transforms, m_manipulator, meshIndex, drawableData);
 }
 
-void ViewScene::setupScene(const parser::SceneNode& node, Object3D& parent, size_t& meshIndex, DrawableData& drawableData) {
+void ViewScene::setupScene(const parser::SceneNode& node,
+                           const parser::SceneTransforms& transforms,
+                           Object3D& parent,
+                           size_t& meshIndex,
+                           DrawableData& drawableData) {
     auto* object = new Object3D{&parent};
 
-    object->setTransformation(node.computeTransformationMatrix());
+    object->setTransformation(transforms.local[node.index()]);
 
-    if (node.mesh.has_value()) {
-        const parser::Mesh& mesh = *node.mesh;
+    if (const parser::Mesh* nodeMesh = node.mesh()) {
+        const parser::Mesh& mesh = *nodeMesh;
         for (size_t meshPartIndex = 0; meshPartIndex < mesh.meshParts.size(); ++meshPartIndex) {
             // Geometry
             Trade::MeshData3D meshData = createMeshData(mesh, meshPartIndex);
@@ -232,8 +240,6 @@ void ViewScene::setupScene(const parser::SceneNode& node, Object3D& parent, size
         }
     }
 
-    if (!node.children.empty()) {
-        for (size_t i = 0; i < node.children.size(); ++i)
-            setupScene(node.children[i], *object, meshIndex, drawableData);
-    }
+    for (const parser::SceneNode& child : node.children())
+        setupScene(child, transforms, *object, meshIndex, drawableData);
 }
\ No newline at end of file
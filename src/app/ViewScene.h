@@ -11,8 +11,10 @@
 #include <Magnum/Shaders/Phong.h>
 
 namespace parser {
+class Bundle;
 struct SceneIndex;
-struct SceneNode;
+class SceneNode;
+struct SceneTransforms;
 } // namespace parser
 
 class TimeManager;
@@ -28,7 +30,7 @@ public:
     void load(size_t sirIndex);
     void unload(size_t sirIndex);
 
-    void setSceneIndex(parser::SceneIndex* sceneIndex);
+    void setSceneIndex(parser::SceneIndex* sceneIndex, parser::Bundle* bundle);
 
     void draw();
     void setViewport(int width, int height);
@@ -49,8 +51,12 @@ private:
 
     void updateCameraTransform();
 
-    void setupScene(const parser::SceneNode& node, DrawableData& drawableData);
-    void setupScene(const parser::SceneNode& node, Object3D& parent, size_t& meshIndex, DrawableData& drawableData);
+    void setupScene(const parser::SceneNode& node, const parser::SceneTransforms& transforms, DrawableData& drawableData);
+    void setupScene(const parser::SceneNode& node,
+                    const parser::SceneTransforms& transforms,
+                    Object3D& parent,
+                    size_t& meshIndex,
+                    DrawableData& drawableData);
 
     Magnum::Shaders::Phong m_texturedShader;
 
@@ -66,6 +72,7 @@ private:
     const InputManager& m_inputManager;
 
     parser::SceneIndex* m_sceneIndex = nullptr;
+    parser::Bundle* m_bundle = nullptr;
 
     const float CameraMovementSpeed = 20.0f;
     const float CameraRotationSpeed = 3.0f;
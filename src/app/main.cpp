@@ -1,11 +1,13 @@
+#include "AllocationCounter.h"
+#include "BatchExport.h"
+#include "Benchmark.h"
 #include "MainWindow.h"
-#include "MeshExporter.h"
 
 #include <parser/PackageParser.h>
-#include <parser/SceneParser.h>
-#include <parser/SharkParser.h>
+#include <parser/SharkDumper.h>
 
 #include <CLI/CLI.hpp>
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
 #pragma warning(push)
@@ -18,6 +20,7 @@
 
 #include <cstdlib>
 #include <fstream>
+#include <iostream>
 
 using namespace parser;
 
@@ -25,12 +28,6 @@ int main(int argc, char** argv) {
     const char* dreamfallTLJResPath = std::getenv("DreamfallTLJResPath");
     PackageParser::instance() = PackageParser(dreamfallTLJResPath);
 
-    auto bundleNames = PackageParser::instance().filenamesWithExtension(".bun");
-    for (const auto& bundleName : bundleNames) {
-        spdlog::info(bundleName);
-        PackageParser::instance().tryExtract(bundleName);
-    }
-
     CLI::App cliapp{"Tool for extracting assets from Dreamfall: The Longest Journey"};
 
     bool isDebugLog = false;
@@ -38,51 +35,71 @@ int main(int argc, char** argv) {
     bool isExportMode = false;
     cliapp.add_flag("--export", isExportMode, "Just export meshes without GUI");
 
-    std::string bundleName = "japan_streets";
-    cliapp.add_option("-p", bundleName, "Bundle name");
-
-    std::string meshName = "";
-    cliapp.add_option("-s", meshName, "Mesh name");
+    ExportOptions exportOptions;
+    exportOptions.bundlePatterns = {"japan_streets"};
+    cliapp.add_option("-p", exportOptions.bundlePatterns, "Bundle names, globs (\"japan_*\") or \"all\" in export mode");
+    cliapp.add_option("-s", exportOptions.meshName, "Mesh name");
+    cliapp.add_option("--jobs", exportOptions.numJobs, "Number of SIRs exported in parallel");
+    bool isRebuild = false;
+    cliapp.add_flag("--rebuild", isRebuild, "Export every SIR, even the ones unchanged since the last export");
+
+    std::string benchmarkName = "";
+    cliapp.add_option("--benchmark", benchmarkName, "Run a benchmark without GUI");
+    BenchmarkOptions benchmarkOptions;
+    cliapp.add_option("--iterations", benchmarkOptions.iterations, "Benchmark iterations");
+
+    std::string dumpPath = "";
+    cliapp.add_option("--dump", dumpPath, "Write a shark3d file (.cdr, .sir, ...) from the paks without GUI");
+    std::string dumpFormat = "json";
+    cliapp.add_option("--dumpFormat", dumpFormat, "Format of --dump")->check(CLI::IsMember({"json", "text"}));
+    std::string outputPath = "";
+    cliapp.add_option("-o,--output", outputPath, "Output file of --dump, stdout by default");
 
     CLI11_PARSE(cliapp, argc, argv);
 
+    // A dump to stdout owns it, the log goes to stderr then
+    if (!dumpPath.empty() && outputPath.empty())
+        spdlog::set_default_logger(spdlog::stderr_color_mt("stderr"));
     if (isDebugLog)
         spdlog::set_level(spdlog::level::debug);
 
-    if (isExportMode) {
+    if (!dumpPath.empty()) {
+        const SharkDumpFormat format = dumpFormat == "json" ? SharkDumpFormat::Json : SharkDumpFormat::Text;
+        if (outputPath.empty()) {
+            std::ios::sync_with_stdio(false);
+            return dumpShark(dumpPath, format, std::cout) ? 0 : 1;
+        }
+        std::ofstream out(outputPath, std::ios::binary);
+        if (!out.is_open()) {
+            spdlog::error("Can't write {}", outputPath);
+            return 1;
+        }
+        return dumpShark(dumpPath, format, out) ? 0 : 1;
+    }
+
+    auto bundleNames = PackageParser::instance().filenamesWithExtension(".bun");
+    for (const auto& bundleName : bundleNames) {
+        spdlog::info(bundleName);
+        PackageParser::instance().tryExtract(bundleName);
+    }
+
+    if (isExportMode || !benchmarkName.empty()) {
         HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
         if (FAILED(hr)) {
             spdlog::critical("DirectXTex failed initialization");
             return 1;
         }
+    }
 
-        std::filesystem::path sceneSDRPath = "data/generated/locations/" + bundleName + ".cdr";
-        SharkParser sceneSharkParser(sceneSDRPath);
-        SceneIndex sceneIndex = sceneSharkParser.parseScene(bundleName);
-
-        for (const auto& sir : sceneIndex.sirs) {
-            if (sir.filename.find("anim") == 0)
-                continue;
-
-            if (!meshName.empty() && sir.filename.find(meshName) == std::string::npos)
-                continue;
-
-            SceneParser scene(sir, bundleName);
-
-            if (scene.sceneRoot.has_value())
-                spdlog::info("SIR: '{}' parsed", sir.filename);
-            else
-                spdlog::warn("SIR: '{}' not parsed", sir.filename);
-
-            if (scene.sceneRoot.has_value()) {
-                std::filesystem::path path = std::filesystem::path("meshes") / bundleName;
-                auto isExtracted = exportScene({*scene.sceneRoot}, path, ExportMode::Multiple);
-                if (!isExtracted)
-                    spdlog::error("Scene: '{}' not extracted", sir.filename);
-            }
-        }
+    if (!benchmarkName.empty()) {
+        setAllocationCounting(true);
+        benchmarkOptions.bundleName = exportOptions.bundlePatterns.front();
+        return runBenchmark(benchmarkName, benchmarkOptions);
+    }
 
-        return 0;
+    if (isExportMode) {
+        exportOptions.isIncremental = !isRebuild;
+        return runExport(exportOptions);
     }
     else {
         const QString appName = "Dreamfall:TLJ Viewer";
@@ -5,6 +5,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include <cstring>
 #include <fstream>
 
 namespace parser {
@@ -17,6 +18,13 @@ std::string BinReader::readStringLine() {
     return result;
 }
 
+std::string_view BinReader::viewStringLine() {
+    const char* begin = data() + m_pos;
+    const size_t length = strnlen(begin, size() - m_pos);
+    m_pos += length + 1;
+    return std::string_view(begin, length);
+}
+
 std::string BinReader::readString(size_t length) {
     std::vector chars = readChars(length); // TODO: Rewrite
     std::string result(chars.begin(), chars.end());
@@ -29,6 +37,12 @@ std::vector<char> BinReader::readChars(size_t length) {
     return result;
 }
 
+std::span<const char> BinReader::viewChars(size_t length) {
+    std::span<const char> result(data() + m_pos, length);
+    m_pos += length;
+    return result;
+}
+
 int64_t BinReader::readSharkNum() {
     int64_t num = 0;
     int n, shift = 0;
@@ -46,13 +60,23 @@ int64_t BinReader::readSharkNum() {
 }
 
 float BinReader::readEndianFloat() {
-    byte arr[4];
-    for (int i = 0; i < 4; i++)
-        arr[3 - i] = readByte();
-    float f = *reinterpret_cast<float*>(arr); // TODO: Check
+    float f;
+    readEndianFloats(&f, 1);
     return f;
 }
 
+void BinReader::readEndianFloats(float* destination, size_t count) {
+    // Independent word swaps, the loop vectorizes
+    const char* source = data() + m_pos;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t word;
+        std::memcpy(&word, source + i * sizeof(word), sizeof(word));
+        word = (word >> 24) | ((word >> 8) & 0xFF00) | ((word << 8) & 0xFF0000) | (word << 24);
+        std::memcpy(destination + i, &word, sizeof(word));
+    }
+    m_pos += count * sizeof(float);
+}
+
 char BinReader::readChar() {
     return data()[m_pos++];
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <filesystem>
+#include <span>
 #include <string>
+#include <string_view>
 
 namespace memory_mapped_file {
 class read_only_mmf;
@@ -29,12 +31,27 @@ public:
         return table;
     }
 
+    // Fills `table` in place, so a pmr table keeps its memory resource
+    template <typename Table>
+    void readTable(Table& table, int length, size_t pos) {
+        Assert(pos);
+        table.resize(length);
+        for (int i = 0; i < length; i++)
+            table[i] = read<typename Table::value_type>();
+    }
+
     std::string readStringLine();
+    // Like readStringLine, but points into the reader data instead of copying it
+    std::string_view viewStringLine();
     std::string readString(size_t length);
     std::vector<char> readChars(size_t length);
+    // Like readChars, but points into the reader data instead of copying it
+    std::span<const char> viewChars(size_t length);
 
     int64_t readSharkNum();
     float readEndianFloat();
+    // `count` big-endian floats at once
+    void readEndianFloats(float* destination, size_t count);
 
     char readChar();
     byte readByte();
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace parser {
+
+// Multi-producer multi-consumer queue connecting two pipeline stages.
+// push() blocks while the queue is full, so a fast stage can't run ahead of a slow one by more than `capacity` items.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+            : m_capacity(capacity == 0 ? 1 : capacity) {}
+
+    // Returns false if the queue was closed, the item is dropped then
+    bool push(T item) {
+        std::unique_lock lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_isClosed || m_items.size() < m_capacity; });
+        if (m_isClosed)
+            return false;
+
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is empty, returns std::nullopt once it is closed and drained
+    std::optional<T> pop() {
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_isClosed || !m_items.empty(); });
+        if (m_items.empty())
+            return std::nullopt;
+
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    // Wakes up every waiting consumer, the items already queued are still popped
+    void close() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_isClosed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_isClosed = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+};
+
+} // namespace parser
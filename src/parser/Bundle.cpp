@@ -0,0 +1,50 @@
+#include "Bundle.h"
+
+#include "BundleParser.h"
+#include "CommonPath.h"
+#include "PackageParser.h"
+
+#include <spdlog/spdlog.h>
+
+namespace parser {
+
+Bundle::Bundle(const std::string& name, bool useMeshCache)
+        : m_name(name) {
+    std::filesystem::path bundlePath = bundlesFolderPath / (name + ".bun");
+    BundleParser bundleParser(bundlePath);
+    m_header = bundleParser.parseHeader();
+    for (const StreamFormat& streamFormat : m_header.streamFormats)
+        m_vertexLayouts.push_back(VertexLayout::compile(streamFormat));
+
+    if (!useMeshCache)
+        return;
+
+    auto source = PackageParser::instance().findSource(bundlePath);
+    if (source.has_value())
+        m_meshCache = std::make_unique<MeshCache>(cacheFolderPath / "meshes" / (name + ".mcache"), *source);
+    else
+        spdlog::debug("{} isn't packed, mesh cache disabled", bundlePath.string());
+}
+
+const std::string& Bundle::name() const {
+    return m_name;
+}
+
+const BundleHeader& Bundle::header() const {
+    return m_header;
+}
+
+const std::vector<VertexLayout>& Bundle::vertexLayouts() const {
+    return m_vertexLayouts;
+}
+
+MeshCache* Bundle::meshCache() const {
+    return m_meshCache.get();
+}
+
+void Bundle::flush() {
+    if (m_meshCache != nullptr)
+        m_meshCache->flush();
+}
+
+} // namespace parser
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "BundleHeader.h"
+#include "MeshCache.h"
+#include "VertexDecoder.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace parser {
+
+// Parsed header, compiled vertex layouts and mesh cache of a .bun file.
+// Read-only once constructed, so the SceneParsers of several SIRs can share it across threads.
+class Bundle {
+public:
+    Bundle(const std::string& name, bool useMeshCache = true);
+
+    const std::string& name() const;
+    const BundleHeader& header() const;
+    const std::vector<VertexLayout>& vertexLayouts() const;
+    MeshCache* meshCache() const; // nullptr if the cache is disabled
+
+    // Writes the meshes decoded since construction to the cache, call once no SceneParser uses the bundle
+    void flush();
+
+private:
+    std::string m_name;
+    BundleHeader m_header;
+    std::vector<VertexLayout> m_vertexLayouts;
+    std::unique_ptr<MeshCache> m_meshCache;
+};
+
+} // namespace parser
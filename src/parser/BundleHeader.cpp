@@ -49,49 +49,70 @@ bool PartHeader::load(BinReader& binReader) {
     return true;
 }
 
+PartTexInfo::PartTexInfo(std::pmr::memory_resource* resource)
+        : texIdx(resource) {}
+
 bool PartTexInfo::load(BinReader& binReader, int numTexStages) {
     cf1 = binReader.read<uint32_t>();
     cf2 = binReader.read<uint32_t>();
     posTex = binReader.read<uint32_t>();
     unknown = binReader.read<int32_t>();
-    texIdx = binReader.readTable<int32_t>(numTexStages, posTex);
+    binReader.readTable(texIdx, numTexStages, posTex);
     return true;
 }
 
+MeshPartInfo::MeshPartInfo(std::pmr::memory_resource* resource)
+        : posTextures(resource)
+        , magic(resource)
+        , boneUsage(resource)
+        , boneVertices(resource)
+        , boneIndices(resource)
+        , tax1(resource)
+        , tax2(resource)
+        , tax3(resource)
+        , xTable(resource)
+        , stageVertices(resource)
+        , stageIndices(resource)
+        , stageAssign(resource)
+        , animKeys(resource)
+        , bonus1(resource)
+        , bonus2(resource)
+        , idxBonus(resource)
+        , tex(resource) {}
+
 bool MeshPartInfo::load(BinReader& binReader) {
+    std::pmr::memory_resource* resource = tex.get_allocator().resource();
     header.load(binReader);
-    posTextures = binReader.readTable<uint32_t>(header.numTextures, 0);
-    magic = binReader.readTable<uint32_t>(header.numMagic, header.posMagic);
+    binReader.readTable(posTextures, header.numTextures, 0);
+    binReader.readTable(magic, header.numMagic, header.posMagic);
     binReader.Assert(header.posIdx);
-    indices = binReader.readChars(header.numIdx * 2);
-    boneUsage = binReader.readTable<uint16_t>(header.numBoneUsage, header.posBoneUsage);
-    boneVertices = binReader.readTable<uint16_t>(header.numBoneStages, header.posBoneVerts);
-    boneIndices = binReader.readTable<uint16_t>(header.numBoneStages, header.posBoneIdx);
-    boneAssign = (header.posBoneAssign == 0)
-                     ? std::nullopt
-                     : std::make_optional<std::vector<uint16_t>>(binReader.readTable<uint16_t>(header.numBoneStages, header.posBoneAssign));
-    tax1 = binReader.readTable<uint32_t>(header.numTax1, header.posTax1);
-    tax2 = binReader.readTable<uint32_t>(header.numTax2, header.posTax2);
-    tax3 = binReader.readTable<uint32_t>(header.numTax3, header.posTax3);
+    indices = binReader.viewChars(header.numIdx * sizeof(uint16_t));
+    binReader.readTable(boneUsage, header.numBoneUsage, header.posBoneUsage);
+    binReader.readTable(boneVertices, header.numBoneStages, header.posBoneVerts);
+    binReader.readTable(boneIndices, header.numBoneStages, header.posBoneIdx);
+    if (header.posBoneAssign != 0)
+        binReader.readTable(boneAssign.emplace(resource), header.numBoneStages, header.posBoneAssign);
+    binReader.readTable(tax1, header.numTax1, header.posTax1);
+    binReader.readTable(tax2, header.numTax2, header.posTax2);
+    binReader.readTable(tax3, header.numTax3, header.posTax3);
     binReader.Assert(header.posXTable);
-    xTable = binReader.readChars(header.lenXTable);
-    stageVertices = binReader.readTable<int32_t>(header.numTexStages, header.posStageVerts);
-    stageIndices = binReader.readTable<int32_t>(header.numTexStages, header.posStageIdx);
-    stageC = (header.posStageC == 0)
-                 ? std::nullopt
-                 : std::make_optional<std::vector<int32_t>>(binReader.readTable<int32_t>(header.numTexStages, header.posStageC));
-    stageAssign = binReader.readTable<int32_t>(header.numTexStages, header.posStageAssign);
-    ;
-    animKeys = binReader.readTable<float>(header.numAnim, header.posAnim);
+    std::span<const char> xTableBytes = binReader.viewChars(header.lenXTable);
+    xTable.assign(xTableBytes.begin(), xTableBytes.end());
+    binReader.readTable(stageVertices, header.numTexStages, header.posStageVerts);
+    binReader.readTable(stageIndices, header.numTexStages, header.posStageIdx);
+    if (header.posStageC != 0)
+        binReader.readTable(stageC.emplace(resource), header.numTexStages, header.posStageC);
+    binReader.readTable(stageAssign, header.numTexStages, header.posStageAssign);
+    binReader.readTable(animKeys, header.numAnim, header.posAnim);
     if ((header.usage & 1) != 0)
-        bonus1 = binReader.readTable<uint32_t>(3 * header.numVertices, header.posBonus[0]);
+        binReader.readTable(bonus1, 3 * header.numVertices, header.posBonus[0]);
     if ((header.usage & 2) != 0)
-        bonus2 = binReader.readTable<uint32_t>(3 * header.numVertices, header.posBonus[1]);
+        binReader.readTable(bonus2, 3 * header.numVertices, header.posBonus[1]);
     if (header.numIdxBonus != 0 && binReader.IsPos(header.posIdxBonus))
-        idxBonus = binReader.readTable<uint32_t>(header.numIdxBonus, 0);
-    tex.resize(header.numTextures);
+        binReader.readTable(idxBonus, header.numIdxBonus, 0);
+    tex.reserve(header.numTextures);
     for (int i = 0; i < header.numTextures; ++i)
-        tex[i].load(binReader, header.numTexStages);
+        tex.emplace_back(resource).load(binReader, header.numTexStages);
     return !tex.empty();
 }
 
@@ -117,24 +138,33 @@ bool MeshHeader::load(BinReader& binReader) {
     return true;
 }
 
+MeshInfo::MeshInfo(std::pmr::memory_resource* resource)
+        : name(resource)
+        , posParts(resource)
+        , boneNames(resource)
+        , boneData(resource)
+        , texIdx(resource)
+        , parts(resource) {}
+
 bool MeshInfo::load(BinReader& binReader) {
+    std::pmr::memory_resource* resource = parts.get_allocator().resource();
     header.load(binReader);
     if (header.numParts == 0)
         return false;
 
-    posParts = binReader.readTable<uint32_t>(header.numParts, 0);
+    binReader.readTable(posParts, header.numParts, 0);
     binReader.Assert(header.posName);
     name = binReader.readStringLine();
-    boneNames.resize(header.numBones);
+    boneNames.reserve(header.numBones);
     for (int k = 0; k < header.numBones; k++) {
-        std::vector<char> boneNameBuffer = binReader.readChars(0x28);
-        boneNames[k] = std::string(boneNameBuffer.begin(), std::find(boneNameBuffer.begin(), boneNameBuffer.end(), '\0'));
+        std::span<const char> boneNameBuffer = binReader.viewChars(0x28);
+        boneNames.emplace_back(boneNameBuffer.begin(), std::find(boneNameBuffer.begin(), boneNameBuffer.end(), '\0'));
     }
-    boneData = binReader.readTable<float>(7 * header.numBones, header.posBoneData);
-    texIdx = binReader.readTable<int32_t>(header.numTextures, header.posTextures);
-    parts.resize(header.numParts);
+    binReader.readTable(boneData, 7 * header.numBones, header.posBoneData);
+    binReader.readTable(texIdx, header.numTextures, header.posTextures);
+    parts.reserve(header.numParts);
     for (int i = 0; i < header.numParts; ++i) {
-        parts[i].load(binReader);
+        parts.emplace_back(resource).load(binReader);
     }
     return !parts.empty();
 }
@@ -3,7 +3,9 @@
 #include "Geometry.h"
 
 #include <array>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -56,31 +58,38 @@ struct PartHeader {
     bool load(BinReader& binReader);
 };
 
+// Tables of MeshInfo, MeshPartInfo and PartTexInfo are allocated from the memory resource they are constructed with,
+// so a whole mesh can be parsed into a monotonic arena and freed in one shot
+
 struct PartTexInfo {
     uint32_t cf1, cf2;
     uint32_t posTex;
     int32_t unknown;
-    std::vector<int32_t> texIdx;
+    std::pmr::vector<int32_t> texIdx;
+
+    explicit PartTexInfo(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     bool load(BinReader& binReader, int numTexStages);
 };
 
 struct MeshPartInfo {
     PartHeader header;
-    std::vector<uint32_t> posTextures;
-    std::vector<uint32_t> magic;
-    std::vector<char> indices;
-    std::vector<uint16_t> boneUsage;
-    std::vector<uint16_t> boneVertices, boneIndices;
-    std::optional<std::vector<uint16_t>> boneAssign;
-    std::vector<uint32_t> tax1, tax2, tax3;
-    std::vector<char> xTable;
-    std::vector<int32_t> stageVertices, stageIndices, stageAssign;
-    std::optional<std::vector<int32_t>> stageC;
-    std::vector<float> animKeys;
-    std::vector<uint32_t> bonus1, bonus2;
-    std::vector<uint32_t> idxBonus;
-    std::vector<PartTexInfo> tex;
+    std::pmr::vector<uint32_t> posTextures;
+    std::pmr::vector<uint32_t> magic;
+    std::span<const char> indices; // uint16_t, valid while the reader the part was loaded from is alive
+    std::pmr::vector<uint16_t> boneUsage;
+    std::pmr::vector<uint16_t> boneVertices, boneIndices;
+    std::optional<std::pmr::vector<uint16_t>> boneAssign;
+    std::pmr::vector<uint32_t> tax1, tax2, tax3;
+    std::pmr::vector<char> xTable;
+    std::pmr::vector<int32_t> stageVertices, stageIndices, stageAssign;
+    std::optional<std::pmr::vector<int32_t>> stageC;
+    std::pmr::vector<float> animKeys;
+    std::pmr::vector<uint32_t> bonus1, bonus2;
+    std::pmr::vector<uint32_t> idxBonus;
+    std::pmr::vector<PartTexInfo> tex;
+
+    explicit MeshPartInfo(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     bool load(BinReader& binReader);
 };
@@ -105,12 +114,14 @@ struct MeshHeader {
 
 struct MeshInfo {
     MeshHeader header;
-    std::string name;
-    std::vector<uint32_t> posParts;
-    std::vector<std::string> boneNames;
-    std::vector<float> boneData;
-    std::vector<int32_t> texIdx;
-    std::vector<MeshPartInfo> parts;
+    std::pmr::string name;
+    std::pmr::vector<uint32_t> posParts;
+    std::pmr::vector<std::pmr::string> boneNames;
+    std::pmr::vector<float> boneData;
+    std::pmr::vector<int32_t> texIdx;
+    std::pmr::vector<MeshPartInfo> parts;
+
+    explicit MeshInfo(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     bool load(BinReader& binReader);
 };
@@ -135,6 +146,10 @@ struct BundleFileEntry {
         }
         return nullptr;
     }
+
+    const MeshEntry* getMeshEntry(const std::string& name) const {
+        return const_cast<BundleFileEntry*>(this)->getMeshEntry(name);
+    }
 };
 
 struct VertexDataHeader {
@@ -164,6 +179,10 @@ struct BundleHeader {
         }
         return nullptr;
     }
+
+    const BundleFileEntry* getFileEntry(const std::string& name) const {
+        return const_cast<BundleHeader*>(this)->getFileEntry(name);
+    }
 };
 
 } // namespace parser
\ No newline at end of file
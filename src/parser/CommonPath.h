@@ -2,4 +2,5 @@
 
 #include <filesystem>
 
-const std::filesystem::path bundlesFolderPath = "bundles";
\ No newline at end of file
+const std::filesystem::path bundlesFolderPath = "bundles";
+const std::filesystem::path cacheFolderPath = "cache";
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "FlatScene.h"
+#include "SceneNode.h"
+
+#include <algorithm>
+
+namespace parser {
+
+size_t FlatScene::size() const {
+    return m_parents.size();
+}
+
+bool FlatScene::empty() const {
+    return m_parents.empty();
+}
+
+SceneNode FlatScene::root() const {
+    return SceneNode(*this, 0);
+}
+
+SceneNode FlatScene::node(NodeIndex index) const {
+    return SceneNode(*this, index);
+}
+
+std::string_view FlatScene::name(NodeIndex index) const {
+    return std::string_view(m_names).substr(m_nameOffsets[index], m_nameLengths[index]);
+}
+
+const Vector3& FlatScene::position(NodeIndex index) const {
+    return m_positions[index];
+}
+
+const Quaternion& FlatScene::rotation(NodeIndex index) const {
+    return m_rotations[index];
+}
+
+float FlatScene::scale(NodeIndex index) const {
+    return m_scales[index];
+}
+
+NodeIndex FlatScene::parent(NodeIndex index) const {
+    return m_parents[index];
+}
+
+NodeIndex FlatScene::subtreeEnd(NodeIndex index) const {
+    return m_subtreeEnds[index];
+}
+
+const Mesh* FlatScene::mesh(NodeIndex index) const {
+    return m_meshIndices[index] == noItem ? nullptr : &m_meshes[m_meshIndices[index]];
+}
+
+Mesh* FlatScene::mesh(NodeIndex index) {
+    return m_meshIndices[index] == noItem ? nullptr : &m_meshes[m_meshIndices[index]];
+}
+
+const PointLight* FlatScene::light(NodeIndex index) const {
+    return m_lightIndices[index] == noItem ? nullptr : &m_lights[m_lightIndices[index]];
+}
+
+std::span<const Vector3> FlatScene::positions() const {
+    return m_positions;
+}
+
+std::span<const Quaternion> FlatScene::rotations() const {
+    return m_rotations;
+}
+
+std::span<const float> FlatScene::scales() const {
+    return m_scales;
+}
+
+std::span<const NodeIndex> FlatScene::parents() const {
+    return m_parents;
+}
+
+std::span<const Mesh> FlatScene::meshes() const {
+    return m_meshes;
+}
+
+std::span<const PointLight> FlatScene::lights() const {
+    return m_lights;
+}
+
+size_t FlatScene::numberOfMeshes() const {
+    size_t number = 0;
+    for (const Mesh& mesh : m_meshes)
+        number += mesh.meshParts.size();
+    return number;
+}
+
+size_t FlatScene::numberOfLights() const {
+    return m_lights.size();
+}
+
+NodeIndex FlatScene::beginNode(NodeIndex parent, std::string_view name, const Vector3& position, const Quaternion& rotation, float scale) {
+    const NodeIndex index = static_cast<NodeIndex>(size());
+    m_positions.push_back(position);
+    m_rotations.push_back(rotation);
+    m_scales.push_back(scale);
+    m_parents.push_back(parent);
+    m_subtreeEnds.push_back(index + 1);
+    m_nameOffsets.push_back(static_cast<uint32_t>(m_names.size()));
+    m_nameLengths.push_back(static_cast<uint32_t>(name.size()));
+    m_names += name;
+    m_meshIndices.push_back(noItem);
+    m_lightIndices.push_back(noItem);
+    return index;
+}
+
+void FlatScene::endNode(NodeIndex index) {
+    m_subtreeEnds[index] = static_cast<NodeIndex>(size());
+}
+
+void FlatScene::setName(NodeIndex index, std::string_view name) {
+    m_nameOffsets[index] = static_cast<uint32_t>(m_names.size());
+    m_nameLengths[index] = static_cast<uint32_t>(name.size());
+    m_names += name;
+}
+
+void FlatScene::setScale(NodeIndex index, float scale) {
+    m_scales[index] = scale;
+}
+
+void FlatScene::setMesh(NodeIndex index, Mesh&& mesh) {
+    m_meshIndices[index] = static_cast<int32_t>(m_meshes.size());
+    m_meshes.push_back(std::move(mesh));
+}
+
+void FlatScene::setLight(NodeIndex index, const PointLight& light) {
+    m_lightIndices[index] = static_cast<int32_t>(m_lights.size());
+    m_lights.push_back(light);
+}
+
+void FlatScene::truncate(NodeIndex index) {
+    if (index >= size())
+        return;
+
+    // Pools are filled in node order, so the items of the dropped nodes are at their ends
+    auto firstItem = [&](const std::vector<int32_t>& itemIndices, size_t poolSize) {
+        auto it = std::find_if(itemIndices.begin() + index, itemIndices.end(), [](int32_t item) { return item != noItem; });
+        return it == itemIndices.end() ? poolSize : static_cast<size_t>(*it);
+    };
+    m_meshes.erase(m_meshes.begin() + firstItem(m_meshIndices, m_meshes.size()), m_meshes.end());
+    m_lights.erase(m_lights.begin() + firstItem(m_lightIndices, m_lights.size()), m_lights.end());
+    m_names.resize(m_nameOffsets[index]);
+
+    m_positions.resize(index);
+    m_rotations.resize(index);
+    m_scales.resize(index);
+    m_parents.resize(index);
+    m_subtreeEnds.resize(index);
+    m_nameOffsets.resize(index);
+    m_nameLengths.resize(index);
+    m_meshIndices.resize(index);
+    m_lightIndices.resize(index);
+}
+
+} // namespace parser
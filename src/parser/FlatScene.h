@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Light.h"
+#include "Mesh.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace parser {
+
+class SceneNode;
+
+using NodeIndex = uint32_t;
+const NodeIndex noNode = ~NodeIndex(0);
+
+// Scene stored as parallel arrays in pre-order: the subtree of node i is [i, subtreeEnd(i)), its first child is i + 1
+// and the next sibling of a child c is subtreeEnd(c). Meshes and lights live in their own pools, referenced by index.
+class FlatScene {
+public:
+    size_t size() const;
+    bool empty() const;
+
+    // Recursive view of the scene, node 0 is the root
+    SceneNode root() const;
+    SceneNode node(NodeIndex index) const;
+
+    std::string_view name(NodeIndex index) const;
+    const Vector3& position(NodeIndex index) const;
+    const Quaternion& rotation(NodeIndex index) const;
+    float scale(NodeIndex index) const;
+    NodeIndex parent(NodeIndex index) const;
+    NodeIndex subtreeEnd(NodeIndex index) const;
+    const Mesh* mesh(NodeIndex index) const;
+    Mesh* mesh(NodeIndex index);
+    const PointLight* light(NodeIndex index) const;
+
+    std::span<const Vector3> positions() const;
+    std::span<const Quaternion> rotations() const;
+    std::span<const float> scales() const;
+    std::span<const NodeIndex> parents() const;
+    std::span<const Mesh> meshes() const;
+    std::span<const PointLight> lights() const;
+
+    size_t numberOfMeshes() const;
+    size_t numberOfLights() const;
+
+    // Building: a node is added before its children and closed after them
+    NodeIndex beginNode(NodeIndex parent, std::string_view name, const Vector3& position, const Quaternion& rotation, float scale);
+    void endNode(NodeIndex index);
+    void setName(NodeIndex index, std::string_view name);
+    void setScale(NodeIndex index, float scale);
+    void setMesh(NodeIndex index, Mesh&& mesh);
+    void setLight(NodeIndex index, const PointLight& light);
+    // Drops the nodes from `index` on with their meshes and lights, used to prune a subtree that turned out empty
+    void truncate(NodeIndex index);
+
+private:
+    static constexpr int32_t noItem = -1;
+
+    std::vector<Vector3> m_positions;
+    std::vector<Quaternion> m_rotations;
+    std::vector<float> m_scales;
+    std::vector<NodeIndex> m_parents;
+    std::vector<NodeIndex> m_subtreeEnds;
+    std::vector<uint32_t> m_nameOffsets;
+    std::vector<uint32_t> m_nameLengths;
+    std::vector<int32_t> m_meshIndices;
+    std::vector<int32_t> m_lightIndices;
+
+    std::string m_names;
+    std::vector<Mesh> m_meshes;
+    std::vector<PointLight> m_lights;
+};
+
+} // namespace parser
@@ -0,0 +1,115 @@
+#include "IndexBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace parser {
+
+bool IndexBuffer::is32Bit() const {
+    return m_is32Bit;
+}
+
+size_t IndexBuffer::size() const {
+    return m_is32Bit ? m_indices32.size() : m_indices16.size();
+}
+
+bool IndexBuffer::empty() const {
+    return size() == 0;
+}
+
+uint32_t IndexBuffer::operator[](size_t i) const {
+    return m_is32Bit ? m_indices32[i] : m_indices16[i];
+}
+
+std::span<const uint16_t> IndexBuffer::indices16() const {
+    return m_indices16;
+}
+
+std::span<const uint32_t> IndexBuffer::indices32() const {
+    return m_indices32;
+}
+
+void IndexBuffer::reserve(size_t size) {
+    if (m_is32Bit)
+        m_indices32.reserve(size);
+    else
+        m_indices16.reserve(size);
+}
+
+void IndexBuffer::clear() {
+    m_indices16.clear();
+    m_indices32.clear();
+    m_is32Bit = false;
+}
+
+void IndexBuffer::widen() {
+    if (m_is32Bit)
+        return;
+
+    m_indices32.reserve(m_indices16.capacity());
+    m_indices32.assign(m_indices16.begin(), m_indices16.end());
+    m_indices16 = std::vector<uint16_t>();
+    m_is32Bit = true;
+}
+
+void IndexBuffer::push_back(uint32_t index) {
+    if (!m_is32Bit && index > std::numeric_limits<uint16_t>::max())
+        widen();
+
+    if (m_is32Bit)
+        m_indices32.push_back(index);
+    else
+        m_indices16.push_back(static_cast<uint16_t>(index));
+}
+
+void IndexBuffer::assign(std::span<const uint16_t> indices) {
+    clear();
+    m_indices16.assign(indices.begin(), indices.end());
+}
+
+void IndexBuffer::assign(std::span<const uint32_t> indices) {
+    clear();
+    m_is32Bit = true;
+    m_indices32.assign(indices.begin(), indices.end());
+}
+
+void IndexBuffer::append(const char* data, size_t count, uint32_t baseVertex) {
+    if (count == 0)
+        return;
+
+    if (!m_is32Bit) {
+        // Copied once, then rebased in place if the rebased indices still fit
+        const size_t first = m_indices16.size();
+        m_indices16.resize(first + count);
+        uint16_t* indices = m_indices16.data() + first;
+        std::memcpy(indices, data, count * sizeof(uint16_t));
+        if (baseVertex == 0)
+            return;
+
+        const uint16_t maxIndex = *std::max_element(indices, indices + count);
+        if (baseVertex + maxIndex <= std::numeric_limits<uint16_t>::max()) {
+            const uint16_t base = static_cast<uint16_t>(baseVertex);
+            for (size_t i = 0; i < count; ++i)
+                indices[i] += base;
+            return;
+        }
+
+        widen();
+        uint32_t* widened = m_indices32.data() + first;
+        for (size_t i = 0; i < count; ++i)
+            widened[i] += baseVertex;
+        return;
+    }
+
+    const size_t first = m_indices32.size();
+    m_indices32.resize(first + count);
+    uint32_t* indices = m_indices32.data() + first;
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t index;
+        std::memcpy(&index, data + i * sizeof(uint16_t), sizeof(uint16_t));
+        indices[i] = baseVertex + index;
+    }
+}
+
+} // namespace parser
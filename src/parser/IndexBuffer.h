@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace parser {
+
+// Triangle indices kept as uint16_t while every index fits and widened to uint32_t once one doesn't,
+// so a merged mesh over 65536 vertices stays a single mesh
+class IndexBuffer {
+public:
+    bool is32Bit() const;
+    size_t size() const;
+    bool empty() const;
+
+    uint32_t operator[](size_t i) const;
+
+    // Only one of them is non-empty, depending on is32Bit()
+    std::span<const uint16_t> indices16() const;
+    std::span<const uint32_t> indices32() const;
+
+    void reserve(size_t size);
+    void clear();
+    void widen();
+
+    void push_back(uint32_t index);
+    void assign(std::span<const uint16_t> indices);
+    void assign(std::span<const uint32_t> indices);
+
+    // Appends `count` little endian uint16_t read from possibly unaligned `data`, adding `baseVertex` to every index
+    void append(const char* data, size_t count, uint32_t baseVertex = 0);
+
+private:
+    std::vector<uint16_t> m_indices16;
+    std::vector<uint32_t> m_indices32;
+    bool m_is32Bit = false;
+};
+
+} // namespace parser
@@ -0,0 +1,35 @@
+#include "MemoryStats.h"
+
+namespace parser {
+
+CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+        : m_upstream(upstream) {}
+
+size_t CountingResource::allocations() const {
+    return m_allocations;
+}
+
+size_t CountingResource::bytes() const {
+    return m_bytes;
+}
+
+void CountingResource::reset() {
+    m_allocations = 0;
+    m_bytes = 0;
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    ++m_allocations;
+    m_bytes += bytes;
+    return m_upstream->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    m_upstream->deallocate(pointer, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+} // namespace parser
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace parser {
+
+// Forwards to the upstream resource and counts what goes through it
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    size_t allocations() const;
+    size_t bytes() const;
+    void reset();
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::memory_resource* m_upstream;
+    size_t m_allocations = 0;
+    size_t m_bytes = 0;
+};
+
+} // namespace parser
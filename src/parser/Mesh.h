@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Geometry.h"
+#include "IndexBuffer.h"
+#include "MorphFrame.h"
+#include "Skin.h"
 
 #include <filesystem>
 #include <optional>
@@ -16,16 +19,33 @@ struct MeshPart {
     std::optional<std::filesystem::path> alphaTexture;
 };
 
+// Move-only, a decoded mesh is owned once from the decoder to its scene node
 struct Mesh {
+    Mesh() = default;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
     std::string name;
 
     std::vector<Vector3> vertices;
     std::vector<Vector3> normals;
     std::vector<Vector2> uvs;
-    std::vector<uint16_t> indices;
+    IndexBuffer indices;
+
+    // Optional streams, empty if the vertex format doesn't have them
+    std::vector<uint32_t> colors;                    // D3DCOLOR, 0xAARRGGBB
+    std::vector<std::vector<Vector2>> extraUvs;      // Float2 channels after the first one
+    std::vector<std::vector<Vector4>> extraChannels; // Float4 channels, stored as is
 
     std::vector<MeshPart> meshParts;
 
+    // Vertex animation frames after frame 0, empty for static meshes
+    std::vector<MorphFrame> morphFrames;
+
+    Skin skin;
+
     bool smoothness = false;
 };
 
@@ -0,0 +1,546 @@
+#include "MeshCache.h"
+#include "BinReader.h"
+#include "Utils.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// Cache file layout, all little-endian:
+//   MeshCacheHeader
+//   MeshCacheEntry[numEntries]   sorted by key, the header table used for lookups
+//   MeshCacheStream[numStreams]  each entry owns a contiguous range of streams
+//   data                         one SoA array per stream, 16-byte aligned
+// A cache is valid only for the .pak entry it was built from, so re-packed bundles are decoded again.
+
+namespace parser {
+
+namespace {
+
+const char cacheMagic[8] = {'D', 'T', 'L', 'J', 'M', 'S', 'H', 'C'};
+// Bumped whenever decoding changes what is stored for a model, not only when the layout changes:
+//   6  vertex formats decoded through compiled VertexLayouts, older files stored some of them as not decoded
+//   7  parts past 65536 vertices kept with 32-bit indices, older files hold those meshes truncated
+//   8  SkinVertex holds one rigidly bound bone
+//   9  SkinVertex holds four weighted bones, weights decoded from boneAssign
+//   10 formats without UVs or with the position past the first channel decoded, older files skipped those parts
+const uint32_t cacheVersion = 10;
+const size_t streamAlignment = 16;
+
+enum MeshCacheFlags : uint32_t
+{
+    Decoded = 1 << 0,
+    Smooth = 1 << 1,
+    HasRescale = 1 << 2,
+};
+
+enum MeshCacheStreamKind : uint32_t
+{
+    Name,          // "<smr file>\0<model name>"
+    Positions,     // Vector3
+    Normals,       // Vector3
+    Uvs,           // Vector2
+    Indices16,     // uint16_t
+    Parts,         // CachedPart
+    Textures,      // '\0' separated bundle texture paths, referenced by CachedPart
+    Colors,        // uint32_t
+    ExtraUvs,      // Vector2, one stream per extra uv set
+    ExtraChannels, // Vector4, one stream per channel
+    Indices32,     // uint32_t, instead of Indices16 when the mesh has more than 65536 vertices
+    MorphFrames,   // CachedMorphFrame
+    MorphVertices, // uint32_t, one stream per morph frame
+    MorphDeltas,   // QuantizedDelta, one stream per morph frame
+    SkinVertices,  // SkinVertex
+    Bones,         // CachedBone
+    BoneNames,     // '\0' separated, one per CachedBone
+};
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t numStreams;
+    uint32_t reserved;
+    uint64_t pakStamp;
+    uint32_t sourceOffset;
+    int32_t sourceSize;
+    uint64_t entriesOffset;
+    uint64_t streamsOffset;
+    uint64_t dataOffset;
+    uint64_t fileSize;
+};
+
+struct CachedPart {
+    int32_t indexBegin, indexEnd;
+    int32_t vertexBegin, vertexEnd;
+    uint32_t firstTexture, numTextures;
+};
+
+struct CachedMorphFrame {
+    float key;
+    float scale;
+};
+
+struct CachedBone {
+    int32_t meshBone;
+    Vector3 position;
+    Quaternion rotation;
+};
+
+size_t alignUp(size_t value) {
+    return (value + streamAlignment - 1) & ~(streamAlignment - 1);
+}
+
+// Whether `count` items of `itemSize` bytes at `offset` lie inside a file of `fileSize` bytes
+bool isInFile(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t fileSize) {
+    return offset <= fileSize && count <= (fileSize - offset) / itemSize;
+}
+
+std::string entryName(const std::string& smrFile, const std::string& modelName) {
+    std::string name = smrFile;
+    name += '\0';
+    name += modelName;
+    return name;
+}
+
+} // namespace
+
+struct MeshCacheEntry {
+    uint64_t key;
+    uint32_t flags;
+    float rescale;
+    uint32_t firstStream;
+    uint32_t numStreams;
+};
+
+struct MeshCacheStream {
+    uint32_t kind;
+    uint32_t count;
+    uint64_t offset; // relative to the data section
+    uint64_t size;
+};
+
+struct MeshCache::Record {
+    MeshCacheEntry entry;
+    std::vector<MeshCacheStream> streams;
+    std::vector<char> data;
+
+    template <typename T>
+    void addStream(uint32_t kind, const T* values, size_t count) {
+        data.resize(alignUp(data.size()));
+        MeshCacheStream stream{kind, static_cast<uint32_t>(count), data.size(), count * sizeof(T)};
+        const char* bytes = reinterpret_cast<const char*>(values);
+        data.insert(data.end(), bytes, bytes + stream.size);
+        streams.push_back(stream);
+    }
+
+    MeshCacheView view() const {
+        MeshCacheView result;
+        result.m_data = data.data();
+        result.m_entry = &entry;
+        result.m_streams = streams.data();
+        return result;
+    }
+};
+
+template <typename T>
+std::span<const T> MeshCacheView::stream(uint32_t kind, size_t index) const {
+    for (uint32_t i = 0; i < m_entry->numStreams; ++i) {
+        const MeshCacheStream& stream = m_streams[i];
+        if (stream.kind == kind && index-- == 0)
+            return std::span<const T>(reinterpret_cast<const T*>(m_data + stream.offset), stream.size / sizeof(T));
+    }
+    return {};
+}
+
+size_t MeshCacheView::numStreams(uint32_t kind) const {
+    return std::count_if(m_streams, m_streams + m_entry->numStreams, [&](const MeshCacheStream& stream) { return stream.kind == kind; });
+}
+
+bool MeshCacheView::isDecoded() const {
+    return (m_entry->flags & MeshCacheFlags::Decoded) != 0;
+}
+
+std::optional<float> MeshCacheView::rescale() const {
+    if ((m_entry->flags & MeshCacheFlags::HasRescale) == 0)
+        return std::nullopt;
+    return m_entry->rescale;
+}
+
+std::span<const Vector3> MeshCacheView::vertices() const {
+    return stream<Vector3>(MeshCacheStreamKind::Positions);
+}
+
+std::span<const Vector3> MeshCacheView::normals() const {
+    return stream<Vector3>(MeshCacheStreamKind::Normals);
+}
+
+std::span<const Vector2> MeshCacheView::uvs() const {
+    return stream<Vector2>(MeshCacheStreamKind::Uvs);
+}
+
+std::span<const uint16_t> MeshCacheView::indices16() const {
+    return stream<uint16_t>(MeshCacheStreamKind::Indices16);
+}
+
+std::span<const uint32_t> MeshCacheView::indices32() const {
+    return stream<uint32_t>(MeshCacheStreamKind::Indices32);
+}
+
+std::span<const uint32_t> MeshCacheView::colors() const {
+    return stream<uint32_t>(MeshCacheStreamKind::Colors);
+}
+
+DecodedMesh MeshCacheView::materialize() const {
+    DecodedMesh decodedMesh;
+    decodedMesh.rescale = rescale();
+    if (!isDecoded())
+        return decodedMesh;
+
+    std::span<const char> name = stream<char>(MeshCacheStreamKind::Name);
+    auto separator = std::find(name.begin(), name.end(), '\0');
+    std::span<const char> textureNames = stream<char>(MeshCacheStreamKind::Textures);
+    std::vector<std::filesystem::path> textures;
+    for (auto it = textureNames.begin(); it != textureNames.end();) {
+        auto end = std::find(it, textureNames.end(), '\0');
+        textures.emplace_back(std::string(it, end));
+        it = (end == textureNames.end()) ? end : end + 1;
+    }
+
+    Mesh& mesh = decodedMesh.mesh.emplace();
+    mesh.name = std::string(separator == name.end() ? separator : separator + 1, name.end());
+    mesh.smoothness = (m_entry->flags & MeshCacheFlags::Smooth) != 0;
+    auto positions = vertices();
+    mesh.vertices.assign(positions.begin(), positions.end());
+    auto normalValues = normals();
+    mesh.normals.assign(normalValues.begin(), normalValues.end());
+    auto uvValues = uvs();
+    mesh.uvs.assign(uvValues.begin(), uvValues.end());
+    if (numStreams(MeshCacheStreamKind::Indices32) != 0)
+        mesh.indices.assign(indices32());
+    else
+        mesh.indices.assign(indices16());
+    auto colorValues = colors();
+    mesh.colors.assign(colorValues.begin(), colorValues.end());
+    mesh.extraUvs.resize(numStreams(MeshCacheStreamKind::ExtraUvs));
+    for (size_t i = 0; i < mesh.extraUvs.size(); ++i) {
+        auto values = stream<Vector2>(MeshCacheStreamKind::ExtraUvs, i);
+        mesh.extraUvs[i].assign(values.begin(), values.end());
+    }
+    mesh.extraChannels.resize(numStreams(MeshCacheStreamKind::ExtraChannels));
+    for (size_t i = 0; i < mesh.extraChannels.size(); ++i) {
+        auto values = stream<Vector4>(MeshCacheStreamKind::ExtraChannels, i);
+        mesh.extraChannels[i].assign(values.begin(), values.end());
+    }
+
+    auto morphFrames = stream<CachedMorphFrame>(MeshCacheStreamKind::MorphFrames);
+    mesh.morphFrames.resize(morphFrames.size());
+    for (size_t i = 0; i < morphFrames.size(); ++i) {
+        MorphFrame& frame = mesh.morphFrames[i];
+        frame.key = morphFrames[i].key;
+        frame.scale = morphFrames[i].scale;
+        auto vertexValues = stream<uint32_t>(MeshCacheStreamKind::MorphVertices, i);
+        frame.vertices.assign(vertexValues.begin(), vertexValues.end());
+        auto deltaValues = stream<QuantizedDelta>(MeshCacheStreamKind::MorphDeltas, i);
+        frame.deltas.assign(deltaValues.begin(), deltaValues.end());
+    }
+
+    auto skinVertices = stream<SkinVertex>(MeshCacheStreamKind::SkinVertices);
+    mesh.skin.vertices.assign(skinVertices.begin(), skinVertices.end());
+    auto bones = stream<CachedBone>(MeshCacheStreamKind::Bones);
+    std::span<const char> boneNames = stream<char>(MeshCacheStreamKind::BoneNames);
+    auto boneName = boneNames.begin();
+    for (const CachedBone& bone : bones) {
+        auto end = std::find(boneName, boneNames.end(), '\0');
+        mesh.skin.bones.push_back(Bone{std::string(boneName, end), bone.meshBone, bone.position, bone.rotation});
+        boneName = (end == boneNames.end()) ? end : end + 1;
+    }
+
+    auto parts = stream<CachedPart>(MeshCacheStreamKind::Parts);
+    mesh.meshParts.resize(parts.size());
+    decodedMesh.textures.resize(parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+        mesh.meshParts[i].indexInterval = std::pair(parts[i].indexBegin, parts[i].indexEnd);
+        mesh.meshParts[i].vertexInterval = std::pair(parts[i].vertexBegin, parts[i].vertexEnd);
+        for (uint32_t t = 0; t < parts[i].numTextures && parts[i].firstTexture + t < textures.size(); ++t)
+            decodedMesh.textures[i].push_back(textures[parts[i].firstTexture + t]);
+    }
+
+    return decodedMesh;
+}
+
+MeshCache::MeshCache(std::filesystem::path path, const PackageSource& source)
+        : m_path(std::move(path))
+        , m_source(source) {
+    open();
+}
+
+MeshCache::~MeshCache() = default;
+
+void MeshCache::open() {
+    m_file.reset();
+    m_entries = {};
+    m_streams = {};
+
+    std::error_code error;
+    if (!std::filesystem::exists(m_path, error) || std::filesystem::file_size(m_path, error) < sizeof(MeshCacheHeader))
+        return;
+
+    auto file = std::make_unique<BinReaderMmap>(m_path);
+    if (!file->isOpen())
+        return;
+
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(file->data());
+    bool isValid = std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) == 0 && header->version == cacheVersion &&
+                   header->fileSize == file->size() && header->pakStamp == m_source.pakStamp &&
+                   header->sourceOffset == m_source.offset && header->sourceSize == m_source.size;
+    if (!isValid) {
+        spdlog::info("Mesh cache {} is stale, it will be rebuilt", m_path.string());
+        return;
+    }
+
+    // Every range the views read is checked once here, a truncated or corrupt file is rebuilt like a stale one
+    const uint64_t fileSize = header->fileSize;
+    isValid = isInFile(header->entriesOffset, header->numEntries, sizeof(MeshCacheEntry), fileSize) &&
+              isInFile(header->streamsOffset, header->numStreams, sizeof(MeshCacheStream), fileSize) &&
+              header->dataOffset <= fileSize && header->dataOffset % streamAlignment == 0;
+    if (isValid) {
+        m_entries = std::span(reinterpret_cast<const MeshCacheEntry*>(file->data() + header->entriesOffset), header->numEntries);
+        m_streams = std::span(reinterpret_cast<const MeshCacheStream*>(file->data() + header->streamsOffset), header->numStreams);
+        for (const MeshCacheEntry& entry : m_entries)
+            isValid = isValid && entry.firstStream <= m_streams.size() && entry.numStreams <= m_streams.size() - entry.firstStream;
+        for (const MeshCacheStream& stream : m_streams) {
+            isValid = isValid && stream.offset % streamAlignment == 0 &&
+                      isInFile(stream.offset, stream.size, 1, fileSize - header->dataOffset);
+        }
+    }
+    if (!isValid) {
+        spdlog::warn("Mesh cache {} is corrupt, it will be rebuilt", m_path.string());
+        m_entries = {};
+        m_streams = {};
+        return;
+    }
+
+    m_file = std::move(file);
+    spdlog::debug("Mesh cache {} opened with {} meshes", m_path.string(), m_entries.size());
+}
+
+std::optional<MeshCacheView> MeshCache::find(const std::string& smrFile, const std::string& modelName) const {
+    std::string name = entryName(smrFile, modelName);
+    uint64_t key = Utils::hashBytes(name.data(), name.size());
+
+    auto mapped = findMapped(key, name);
+    if (mapped.has_value())
+        return mapped;
+
+    std::lock_guard lock(m_pendingMutex);
+    for (const Record& record : m_pending) {
+        if (record.entry.key != key)
+            continue;
+        MeshCacheView view = record.view();
+        std::span<const char> recordName = view.stream<char>(MeshCacheStreamKind::Name);
+        if (std::equal(recordName.begin(), recordName.end(), name.begin(), name.end()))
+            return view;
+    }
+    return std::nullopt;
+}
+
+std::optional<MeshCacheView> MeshCache::findMapped(uint64_t key, const std::string& name) const {
+    if (m_file == nullptr)
+        return std::nullopt;
+
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(m_file->data());
+    auto it = std::lower_bound(
+        m_entries.begin(), m_entries.end(), key, [](const MeshCacheEntry& entry, uint64_t value) { return entry.key < value; });
+    for (; it != m_entries.end() && it->key == key; ++it) {
+        MeshCacheView view;
+        view.m_data = m_file->data() + header->dataOffset;
+        view.m_entry = &*it;
+        view.m_streams = m_streams.data() + it->firstStream;
+        std::span<const char> entryName = view.stream<char>(MeshCacheStreamKind::Name);
+        if (std::equal(entryName.begin(), entryName.end(), name.begin(), name.end()))
+            return view;
+    }
+    return std::nullopt;
+}
+
+void MeshCache::store(const std::string& smrFile, const std::string& modelName, const DecodedMesh& decodedMesh) {
+    std::string name = entryName(smrFile, modelName);
+
+    Record record;
+    record.entry.key = Utils::hashBytes(name.data(), name.size());
+    record.entry.flags = 0;
+    record.entry.rescale = decodedMesh.rescale.value_or(1.0f);
+    if (decodedMesh.rescale.has_value())
+        record.entry.flags |= MeshCacheFlags::HasRescale;
+    record.addStream(MeshCacheStreamKind::Name, name.data(), name.size());
+
+    if (decodedMesh.mesh.has_value()) {
+        const Mesh& mesh = *decodedMesh.mesh;
+        record.entry.flags |= MeshCacheFlags::Decoded;
+        if (mesh.smoothness)
+            record.entry.flags |= MeshCacheFlags::Smooth;
+
+        record.addStream(MeshCacheStreamKind::Positions, mesh.vertices.data(), mesh.vertices.size());
+        record.addStream(MeshCacheStreamKind::Normals, mesh.normals.data(), mesh.normals.size());
+        record.addStream(MeshCacheStreamKind::Uvs, mesh.uvs.data(), mesh.uvs.size());
+        if (mesh.indices.is32Bit())
+            record.addStream(MeshCacheStreamKind::Indices32, mesh.indices.indices32().data(), mesh.indices.size());
+        else
+            record.addStream(MeshCacheStreamKind::Indices16, mesh.indices.indices16().data(), mesh.indices.size());
+        record.addStream(MeshCacheStreamKind::Colors, mesh.colors.data(), mesh.colors.size());
+        for (const auto& extraUvs : mesh.extraUvs)
+            record.addStream(MeshCacheStreamKind::ExtraUvs, extraUvs.data(), extraUvs.size());
+        for (const auto& extraChannel : mesh.extraChannels)
+            record.addStream(MeshCacheStreamKind::ExtraChannels, extraChannel.data(), extraChannel.size());
+
+        std::vector<CachedMorphFrame> morphFrames;
+        for (const MorphFrame& frame : mesh.morphFrames)
+            morphFrames.push_back(CachedMorphFrame{frame.key, frame.scale});
+        record.addStream(MeshCacheStreamKind::MorphFrames, morphFrames.data(), morphFrames.size());
+        for (const MorphFrame& frame : mesh.morphFrames) {
+            record.addStream(MeshCacheStreamKind::MorphVertices, frame.vertices.data(), frame.vertices.size());
+            record.addStream(MeshCacheStreamKind::MorphDeltas, frame.deltas.data(), frame.deltas.size());
+        }
+
+        std::vector<CachedBone> bones;
+        std::string boneNames;
+        for (const Bone& bone : mesh.skin.bones) {
+            bones.push_back(CachedBone{bone.meshBone, bone.position, bone.rotation});
+            boneNames += bone.name;
+            boneNames += '\0';
+        }
+        record.addStream(MeshCacheStreamKind::SkinVertices, mesh.skin.vertices.data(), mesh.skin.vertices.size());
+        record.addStream(MeshCacheStreamKind::Bones, bones.data(), bones.size());
+        record.addStream(MeshCacheStreamKind::BoneNames, boneNames.data(), boneNames.size());
+
+        std::vector<CachedPart> parts(mesh.meshParts.size());
+        std::string textureNames;
+        uint32_t numTextures = 0;
+        for (size_t i = 0; i < parts.size(); ++i) {
+            const MeshPart& meshPart = mesh.meshParts[i];
+            parts[i] = CachedPart{meshPart.indexInterval.first,
+                                  meshPart.indexInterval.second,
+                                  meshPart.vertexInterval.first,
+                                  meshPart.vertexInterval.second,
+                                  numTextures,
+                                  0};
+            if (i < decodedMesh.textures.size()) {
+                for (const auto& texture : decodedMesh.textures[i]) {
+                    textureNames += texture.string();
+                    textureNames += '\0';
+                    ++parts[i].numTextures;
+                }
+                numTextures += parts[i].numTextures;
+            }
+        }
+        record.addStream(MeshCacheStreamKind::Parts, parts.data(), parts.size());
+        record.addStream(MeshCacheStreamKind::Textures, textureNames.data(), textureNames.size());
+    }
+
+    record.entry.firstStream = 0;
+    record.entry.numStreams = static_cast<uint32_t>(record.streams.size());
+    std::lock_guard lock(m_pendingMutex);
+    m_pending.push_back(std::move(record));
+}
+
+void MeshCache::flush() {
+    if (m_pending.empty())
+        return;
+
+    std::vector<MeshCacheView> views;
+    views.reserve(m_entries.size() + m_pending.size());
+    const MeshCacheHeader* mappedHeader = m_file ? reinterpret_cast<const MeshCacheHeader*>(m_file->data()) : nullptr;
+    for (const MeshCacheEntry& entry : m_entries) {
+        MeshCacheView view;
+        view.m_data = m_file->data() + mappedHeader->dataOffset;
+        view.m_entry = &entry;
+        view.m_streams = m_streams.data() + entry.firstStream;
+        views.push_back(view);
+    }
+    for (const Record& record : m_pending)
+        views.push_back(record.view());
+    std::stable_sort(
+        views.begin(), views.end(), [](const MeshCacheView& l, const MeshCacheView& r) { return l.m_entry->key < r.m_entry->key; });
+
+    std::vector<MeshCacheEntry> entries;
+    std::vector<MeshCacheStream> streams;
+    std::vector<char> data;
+    entries.reserve(views.size());
+    for (size_t i = 0; i < views.size(); ++i) {
+        const MeshCacheView& view = views[i];
+        // Models stored twice before a flush keep their first copy
+        std::span<const char> name = view.stream<char>(MeshCacheStreamKind::Name);
+        bool isDuplicate = false;
+        for (size_t j = i; j-- > 0 && views[j].m_entry->key == view.m_entry->key && !isDuplicate;) {
+            std::span<const char> otherName = views[j].stream<char>(MeshCacheStreamKind::Name);
+            isDuplicate = std::equal(name.begin(), name.end(), otherName.begin(), otherName.end());
+        }
+        if (isDuplicate)
+            continue;
+
+        MeshCacheEntry entry = *view.m_entry;
+        entry.firstStream = static_cast<uint32_t>(streams.size());
+        for (uint32_t s = 0; s < entry.numStreams; ++s) {
+            MeshCacheStream stream = view.m_streams[s];
+            data.resize(alignUp(data.size()));
+            const char* bytes = view.m_data + stream.offset;
+            stream.offset = data.size();
+            data.insert(data.end(), bytes, bytes + stream.size);
+            streams.push_back(stream);
+        }
+        entries.push_back(entry);
+    }
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.numEntries = static_cast<uint32_t>(entries.size());
+    header.numStreams = static_cast<uint32_t>(streams.size());
+    header.pakStamp = m_source.pakStamp;
+    header.sourceOffset = m_source.offset;
+    header.sourceSize = m_source.size;
+    header.entriesOffset = sizeof(MeshCacheHeader);
+    header.streamsOffset = header.entriesOffset + entries.size() * sizeof(MeshCacheEntry);
+    header.dataOffset = alignUp(header.streamsOffset + streams.size() * sizeof(MeshCacheStream));
+    header.fileSize = header.dataOffset + data.size();
+
+    // The mapping has to be released before the file is replaced
+    m_pending.clear();
+    m_file.reset();
+
+    std::filesystem::path tempPath = m_path;
+    tempPath += ".tmp";
+    std::filesystem::create_directories(m_path.parent_path());
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            spdlog::error("Can't write mesh cache {}", tempPath.string());
+            return;
+        }
+        const std::vector<char> padding(streamAlignment, 0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MeshCacheEntry));
+        out.write(reinterpret_cast<const char*>(streams.data()), streams.size() * sizeof(MeshCacheStream));
+        out.write(padding.data(), header.dataOffset - header.streamsOffset - streams.size() * sizeof(MeshCacheStream));
+        out.write(data.data(), data.size());
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, m_path, error);
+    if (error)
+        spdlog::error("Can't replace mesh cache {}: {}", m_path.string(), error.message());
+    else
+        spdlog::debug("Mesh cache {} written with {} meshes", m_path.string(), entries.size());
+
+    open();
+}
+
+size_t MeshCache::size() const {
+    std::lock_guard lock(m_pendingMutex);
+    return m_entries.size() + m_pending.size();
+}
+
+} // namespace parser
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Mesh.h"
+#include "PackageParser.h"
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace parser {
+
+class BinReaderMmap;
+struct MeshCacheEntry;
+struct MeshCacheStream;
+
+// Result of decoding one model of a bundle, before its textures are converted
+struct DecodedMesh {
+    std::optional<Mesh> mesh;
+    std::optional<float> rescale;
+    std::vector<std::vector<std::filesystem::path>> textures; // bundle texture paths per mesh part
+};
+
+// Zero-copy view of a cached model. Spans point into the mapped cache file and stay valid until the next store() or flush().
+class MeshCacheView {
+public:
+    bool isDecoded() const;
+    std::optional<float> rescale() const;
+
+    std::span<const Vector3> vertices() const;
+    std::span<const Vector3> normals() const;
+    std::span<const Vector2> uvs() const;
+    // Only one of them is non-empty, see IndexBuffer
+    std::span<const uint16_t> indices16() const;
+    std::span<const uint32_t> indices32() const;
+    std::span<const uint32_t> colors() const;
+
+    // Copies every stream once into an owning mesh
+    DecodedMesh materialize() const;
+
+private:
+    friend class MeshCache;
+
+    template <typename T>
+    std::span<const T> stream(uint32_t kind, size_t index = 0) const;
+    size_t numStreams(uint32_t kind) const;
+
+    const char* m_data = nullptr;
+    const MeshCacheEntry* m_entry = nullptr;
+    const MeshCacheStream* m_streams = nullptr;
+};
+
+// Per-bundle cache of decoded meshes (see MeshCache.cpp for the file layout).
+// The file is memory mapped on open; new entries are kept in memory until flush() rewrites it.
+// find() and store() may be called from several threads, flush() only once they are done.
+class MeshCache {
+public:
+    MeshCache(std::filesystem::path path, const PackageSource& source);
+    ~MeshCache();
+
+    std::optional<MeshCacheView> find(const std::string& smrFile, const std::string& modelName) const;
+    void store(const std::string& smrFile, const std::string& modelName, const DecodedMesh& decodedMesh);
+
+    void flush();
+
+    size_t size() const;
+
+private:
+    struct Record;
+
+    void open();
+    std::optional<MeshCacheView> findMapped(uint64_t key, const std::string& name) const;
+
+    std::filesystem::path m_path;
+    PackageSource m_source;
+
+    std::unique_ptr<BinReaderMmap> m_file;
+    std::span<const MeshCacheEntry> m_entries;
+    std::span<const MeshCacheStream> m_streams;
+
+    // A deque keeps the views of pending records valid while other threads store new ones
+    std::deque<Record> m_pending;
+    mutable std::mutex m_pendingMutex;
+};
+
+} // namespace parser
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "MorphFrame.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace parser {
+
+Vector3 MorphFrame::delta(size_t i) const {
+    const QuantizedDelta& q = deltas[i];
+    return Vector3{q.x * scale, q.y * scale, q.z * scale};
+}
+
+std::vector<Vector3> MorphFrame::positions(const std::vector<Vector3>& baseVertices) const {
+    std::vector<Vector3> result = baseVertices;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        Vector3& p = result[vertices[i]];
+        const Vector3 d = delta(i);
+        p.x += d.x;
+        p.y += d.y;
+        p.z += d.z;
+    }
+    return result;
+}
+
+size_t MorphFrame::memorySize() const {
+    return sizeof(MorphFrame) + vertices.size() * sizeof(uint32_t) + deltas.size() * sizeof(QuantizedDelta);
+}
+
+MorphFrame MorphFrame::build(float key, const std::vector<uint32_t>& vertices, const std::vector<Vector3>& deltas, float threshold) {
+    MorphFrame frame;
+    frame.key = key;
+
+    float maxDelta = 0.0f;
+    for (const Vector3& d : deltas)
+        maxDelta = std::max({maxDelta, std::abs(d.x), std::abs(d.y), std::abs(d.z)});
+    if (maxDelta <= threshold)
+        return frame;
+
+    const float maxQuantized = std::numeric_limits<int16_t>::max();
+    frame.scale = maxDelta / maxQuantized;
+    const float invScale = 1.0f / frame.scale;
+    for (size_t i = 0; i < deltas.size(); ++i) {
+        const Vector3& d = deltas[i];
+        if (std::abs(d.x) <= threshold && std::abs(d.y) <= threshold && std::abs(d.z) <= threshold)
+            continue;
+
+        frame.vertices.push_back(vertices[i]);
+        frame.deltas.push_back(QuantizedDelta{static_cast<int16_t>(std::lround(d.x * invScale)),
+                                              static_cast<int16_t>(std::lround(d.y * invScale)),
+                                              static_cast<int16_t>(std::lround(d.z * invScale))});
+    }
+    return frame;
+}
+
+} // namespace parser
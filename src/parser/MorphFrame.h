@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Geometry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace parser {
+
+struct QuantizedDelta {
+    int16_t x, y, z;
+};
+
+// One vertex animation frame, stored as the vertices that move relative to frame 0 (Mesh::vertices)
+// with their position deltas quantized to int16 against a per-frame scale
+struct MorphFrame {
+    float key = 0.0f;                   // animKeys value of the frame
+    float scale = 0.0f;                 // delta = quantized * scale
+    std::vector<uint32_t> vertices;     // indices of the moved vertices, ascending
+    std::vector<QuantizedDelta> deltas; // one per moved vertex
+
+    Vector3 delta(size_t i) const;
+
+    // Positions of every vertex of the mesh in this frame
+    std::vector<Vector3> positions(const std::vector<Vector3>& baseVertices) const;
+
+    size_t memorySize() const;
+
+    // Quantizes float deltas, vertices whose delta is below `threshold` on every axis are dropped
+    static MorphFrame build(float key, const std::vector<uint32_t>& vertices, const std::vector<Vector3>& deltas, float threshold = 1e-6f);
+};
+
+} // namespace parser
@@ -6,11 +6,24 @@
 #include <algorithm>
 #include <cassert>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace {
 
+// The index is read-only after construction, only extraction state is shared between threads: the set of extracted
+// paths is guarded by extractedMutex and every path is extracted under its own mutex, so different files copy in parallel
+std::mutex extractedMutex;
+
+std::mutex& extractMutex(const std::filesystem::path& path) {
+    static std::mutex mutex;
+    static std::map<std::string, std::mutex> extractMutexes;
+    std::lock_guard lock(mutex);
+    return extractMutexes[path.string()];
+}
+
 const std::vector<char> charTable{'\0', 'a', 'b',  'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l',  'm', 'n',
                                   'o',  'p', 'q',  'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '\\', '?', '?',
                                   '-',  '_', '\'', '.', '0', '1', '2', '3', '4', '5', '6', '7', '8',  '9'};
@@ -101,33 +114,68 @@ PackageParser::PackageParser(const std::filesystem::path& path) {
 }
 
 void PackageParser::tryExtract(const std::filesystem::path& path) {
-    if (m_extracted.contains(path.string()))
-        return;
+    std::lock_guard pathLock(extractMutex(path));
+    {
+        std::lock_guard lock(extractedMutex);
+        if (m_extracted.contains(path.string()))
+            return;
+    }
 
-    std::string innerPath = path.string();
-    std::replace(innerPath.begin(), innerPath.end(), '/', '\\');
-    spdlog::debug("Try to extract {}", innerPath);
+    spdlog::debug("Try to extract {}", path.string());
 
     PackageIndex* pakIndex = nullptr;
-    PackageFileEntry* entry = nullptr;
-    for (auto& it : m_pakIndices) {
-        entry = findFile(it.second, innerPath);
-        if (entry != nullptr) {
-            pakIndex = &it.second;
-            break;
-        }
+    PackageFileEntry* entry = locate(path, pakIndex);
+    if (entry != nullptr && isExtracted(*pakIndex, *entry, path)) {
+        markExtracted(path);
+        spdlog::debug("{} is already extracted", path.string());
     }
-
-    if (pakIndex != nullptr && entry != nullptr) {
+    else if (entry != nullptr) {
         extract(*pakIndex, *entry, path);
-        m_extracted.insert(path.string());
+        markExtracted(path);
         spdlog::debug("Extracted successfully to {}", path.string());
     }
     else {
-        spdlog::warn("{} not found", innerPath);
+        spdlog::warn("{} not found", path.string());
     }
 }
 
+std::optional<PackageSource> PackageParser::findSource(const std::filesystem::path& innerPath) {
+    PackageIndex* pakIndex = nullptr;
+    PackageFileEntry* entry = locate(innerPath, pakIndex);
+    if (entry == nullptr)
+        return std::nullopt;
+
+    std::error_code error;
+    auto writeTime = std::filesystem::last_write_time(pakIndex->path, error);
+    int64_t ticks = error ? 0 : static_cast<int64_t>(writeTime.time_since_epoch().count());
+    std::string pakPath = pakIndex->path.string();
+    uint64_t pakStamp = Utils::hashBytes(pakPath.data(), pakPath.size());
+    pakStamp = Utils::hashBytes(&ticks, sizeof(ticks), pakStamp);
+    return PackageSource{pakStamp, entry->offset, entry->size};
+}
+
+std::unique_ptr<BinReaderMmap> PackageParser::openEntry(const std::filesystem::path& innerPath) {
+    PackageIndex* pakIndex = nullptr;
+    PackageFileEntry* entry = locate(innerPath, pakIndex);
+    if (entry == nullptr)
+        return nullptr;
+    return std::make_unique<BinReaderMmap>(pakIndex->path, entry->offset, entry->size);
+}
+
+PackageFileEntry* PackageParser::locate(const std::filesystem::path& path, PackageIndex*& outPakIndex) {
+    std::string innerPath = path.string();
+    std::replace(innerPath.begin(), innerPath.end(), '/', '\\');
+
+    for (auto& it : m_pakIndices) {
+        PackageFileEntry* entry = findFile(it.second, innerPath);
+        if (entry != nullptr) {
+            outPakIndex = &it.second;
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
 std::vector<std::string> PackageParser::filenamesWithExtension(const std::string& extension) const {
     if (extension.empty() || extension.front() != '.')
         throw std::invalid_argument(fmt::format("{} is incorrect extension. Example of right input is \".bun\"", extension));
@@ -149,6 +197,24 @@ std::vector<std::string> PackageParser::filenamesWithExtension(const std::string
     return result;
 }
 
+void PackageParser::markExtracted(const std::filesystem::path& path) {
+    std::lock_guard lock(extractedMutex);
+    m_extracted.insert(path.string());
+}
+
+bool PackageParser::isExtracted(const PackageIndex& pakIndex, const PackageFileEntry& entry, const std::filesystem::path& path) const {
+    // A file left by a previous run is reused if it has the entry size and is newer than the .pak
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    if (error || size != static_cast<uintmax_t>(entry.size))
+        return false;
+    auto fileTime = std::filesystem::last_write_time(path, error);
+    if (error)
+        return false;
+    auto pakTime = std::filesystem::last_write_time(pakIndex.path, error);
+    return !error && fileTime >= pakTime;
+}
+
 void PackageParser::extract(const PackageIndex& pakIndex, const PackageFileEntry& entry, const std::filesystem::path& outputPath) const {
     std::filesystem::create_directories(outputPath.parent_path());
     std::ofstream out(outputPath.string(), std::ios::binary);
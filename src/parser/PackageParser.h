@@ -3,6 +3,8 @@
 #include "BinReader.h"
 
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -21,6 +23,15 @@ struct PackageFileEntry {
     bool isRealFile() const;
 };
 
+// Identifies the bytes an extracted file came from, so caches built from it can be invalidated
+struct PackageSource {
+    uint64_t pakStamp; // hash of the .pak path and its last write time
+    uint32_t offset;
+    int32_t size;
+
+    bool operator==(const PackageSource&) const = default;
+};
+
 struct PackageIndex {
     PackageIndex() = default;
     PackageIndex(const std::filesystem::path& path);
@@ -40,10 +51,18 @@ public:
 
     std::vector<std::string> filenamesWithExtension(const std::string& extension) const;
 
+    // Safe to call from several threads. A file is extracted once, files left by a previous run are reused.
     void tryExtract(const std::filesystem::path& innerPath);
+    std::optional<PackageSource> findSource(const std::filesystem::path& innerPath);
+    // Maps a file inside its .pak instead of extracting it, nullptr if no .pak has it. Safe to call from several threads.
+    std::unique_ptr<BinReaderMmap> openEntry(const std::filesystem::path& innerPath);
 
 private:
+    PackageFileEntry* locate(const std::filesystem::path& innerPath, PackageIndex*& outPakIndex);
+
+    bool isExtracted(const PackageIndex& pakIndex, const PackageFileEntry& entry, const std::filesystem::path& path) const;
     void extract(const PackageIndex& pakIndex, const PackageFileEntry& entry, const std::filesystem::path& outputPath) const;
+    void markExtracted(const std::filesystem::path& path);
 
     PackageFileEntry* findFile(PackageIndex& pakIndex, std::string innerPath) const;
     PackageFileEntry* findFile(PackageIndex& pakIndex, std::string innerPathLeft, std::string innerPathPassed, int offset) const;
@@ -1,13 +1,18 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace parser {
 
+class SharkDocument;
+
 struct SirEntry {
     std::string filename;
     std::string sirPath;
+    // data/root of the SIR when parseSirDocuments read it ahead, SceneParser reads the file itself otherwise
+    std::shared_ptr<const SharkDocument> hierarchy;
 };
 
 struct SceneIndex {
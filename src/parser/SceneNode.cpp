@@ -29,35 +29,90 @@ Magnum::Vector3 toEulerAngles(Magnum::Quaternion q) {
     return angles;
 }
 
-void numberOfMeshes(const parser::SceneNode& node, size_t& number) {
-    if (node.mesh.has_value())
-        number += node.mesh->meshParts.size();
-
-    if (!node.children.empty()) {
-        for (size_t i = 0; i < node.children.size(); ++i)
-            numberOfMeshes(node.children[i], number);
-    }
-}
-
 void print(const parser::SceneNode& node, std::string offset) {
-    bool hasMesh = node.mesh.has_value();
-    bool hasTexture = node.mesh.has_value() && !node.mesh->meshParts[0].textures[0].empty();
-    fmt::print("{}{} {}{}\n", offset, node.name, hasMesh ? "(m)" : "", hasTexture ? "(t)" : "");
+    const parser::Mesh* mesh = node.mesh();
+    bool hasMesh = mesh != nullptr;
+    bool hasTexture = mesh != nullptr && !mesh->meshParts[0].textures[0].empty();
+    fmt::print("{}{} {}{}\n", offset, node.name(), hasMesh ? "(m)" : "", hasTexture ? "(t)" : "");
 
-    if (!node.children.empty()) {
-        for (size_t i = 0; i < node.children.size(); ++i)
-            print(node.children[i], offset + " ");
-    }
+    for (const parser::SceneNode& child : node.children())
+        print(child, offset + " ");
 }
 
 } // namespace
 
 namespace parser {
 
+SceneNode::ChildIterator::ChildIterator(const FlatScene* scene, NodeIndex index)
+        : m_scene(scene)
+        , m_index(index) {}
+
+SceneNode SceneNode::ChildIterator::operator*() const {
+    return SceneNode(*m_scene, m_index);
+}
+
+SceneNode::ChildIterator& SceneNode::ChildIterator::operator++() {
+    m_index = m_scene->subtreeEnd(m_index);
+    return *this;
+}
+
+SceneNode::ChildIterator SceneNode::Children::begin() const {
+    return first;
+}
+
+SceneNode::ChildIterator SceneNode::Children::end() const {
+    return last;
+}
+
+bool SceneNode::Children::empty() const {
+    return first == last;
+}
+
+SceneNode::SceneNode(const FlatScene& scene, NodeIndex index)
+        : m_scene(&scene)
+        , m_index(index) {}
+
+const FlatScene& SceneNode::scene() const {
+    return *m_scene;
+}
+
+NodeIndex SceneNode::index() const {
+    return m_index;
+}
+
+std::string_view SceneNode::name() const {
+    return m_scene->name(m_index);
+}
+
+const Mesh* SceneNode::mesh() const {
+    return m_scene->mesh(m_index);
+}
+
+const PointLight* SceneNode::light() const {
+    return m_scene->light(m_index);
+}
+
+const Vector3& SceneNode::position() const {
+    return m_scene->position(m_index);
+}
+
+const Quaternion& SceneNode::rotation() const {
+    return m_scene->rotation(m_index);
+}
+
+float SceneNode::scale() const {
+    return m_scene->scale(m_index);
+}
+
+SceneNode::Children SceneNode::children() const {
+    return Children{ChildIterator(m_scene, m_index + 1), ChildIterator(m_scene, m_scene->subtreeEnd(m_index))};
+}
+
 Magnum::Matrix4 SceneNode::computeTransformationMatrix() const {
-    float magnumScale = 1.0f / scale;
-    Magnum::Vector3 magnumPosition(position.x, position.y, position.z);
-    Magnum::Quaternion magnumRotation(Magnum::Vector3(rotation.x, rotation.y, rotation.z), rotation.w);
+    float magnumScale = 1.0f / scale();
+    Magnum::Vector3 magnumPosition(position().x, position().y, position().z);
+    const Quaternion& nodeRotation = rotation();
+    Magnum::Quaternion magnumRotation(Magnum::Vector3(nodeRotation.x, nodeRotation.y, nodeRotation.z), nodeRotation.w);
     magnumPosition = magnumRotation.inverted().transformVector(magnumPosition);
     if (!magnumRotation.isNormalized()) {
         magnumScale *= magnumRotation.dot();
@@ -73,9 +128,10 @@ Magnum::Matrix4 SceneNode::computeTransformationMatrix() const {
 }
 
 Transofrmation SceneNode::computeTransformation() const {
-    float magnumScale = 1.0f / scale;
-    Magnum::Vector3 magnumPosition(position.x, position.y, position.z);
-    Magnum::Quaternion magnumRotation(Magnum::Vector3(rotation.x, rotation.y, rotation.z), rotation.w);
+    float magnumScale = 1.0f / scale();
+    Magnum::Vector3 magnumPosition(position().x, position().y, position().z);
+    const Quaternion& nodeRotation = rotation();
+    Magnum::Quaternion magnumRotation(Magnum::Vector3(nodeRotation.x, nodeRotation.y, nodeRotation.z), nodeRotation.w);
     if (!magnumRotation.isNormalized()) {
         magnumScale *= magnumRotation.dot();
         magnumRotation = magnumRotation.normalized();
@@ -83,12 +139,23 @@ Transofrmation SceneNode::computeTransformation() const {
 
     Magnum::Vector3 euler = toEulerAngles(magnumRotation);
 
-    return Transofrmation{position, Vector3{euler.x(), euler.y(), euler.z()}, magnumScale};
+    return Transofrmation{position(), Vector3{euler.x(), euler.y(), euler.z()}, magnumScale};
 }
 
+// The subtree is contiguous, so counting doesn't need to recurse
 size_t SceneNode::numberOfMeshes() const {
     size_t number = 0;
-    ::numberOfMeshes(*this, number);
+    for (NodeIndex i = m_index; i < m_scene->subtreeEnd(m_index); ++i) {
+        if (const Mesh* mesh = m_scene->mesh(i))
+            number += mesh->meshParts.size();
+    }
+    return number;
+}
+
+size_t SceneNode::numberOfLights() const {
+    size_t number = 0;
+    for (NodeIndex i = m_index; i < m_scene->subtreeEnd(m_index); ++i)
+        number += m_scene->light(i) != nullptr ? 1 : 0;
     return number;
 }
 
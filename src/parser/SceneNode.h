@@ -1,12 +1,13 @@
 #pragma once
 
-#include "Light.h"
-#include "Mesh.h"
+#include "FlatScene.h"
 
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Matrix4.h>
 
-#include <optional>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
 
 namespace parser {
 
@@ -16,17 +17,50 @@ struct Transofrmation {
     float scale;
 };
 
-struct SceneNode {
-    std::string name;
+// Recursive view of a FlatScene node, valid while the scene is alive and not modified
+class SceneNode {
+public:
+    class ChildIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SceneNode;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = SceneNode;
 
-    std::optional<Mesh> mesh;
-    std::optional<PointLight> light;
+        ChildIterator(const FlatScene* scene, NodeIndex index);
 
-    Vector3 position;
-    Quaternion rotation;
-    float scale;
+        SceneNode operator*() const;
+        ChildIterator& operator++();
+        bool operator==(const ChildIterator& other) const = default;
+
+    private:
+        const FlatScene* m_scene;
+        NodeIndex m_index;
+    };
+
+    struct Children {
+        ChildIterator first, last;
+
+        ChildIterator begin() const;
+        ChildIterator end() const;
+        bool empty() const;
+    };
+
+    SceneNode(const FlatScene& scene, NodeIndex index);
 
-    std::vector<SceneNode> children;
+    const FlatScene& scene() const;
+    NodeIndex index() const;
+
+    std::string_view name() const;
+    const Mesh* mesh() const;
+    const PointLight* light() const;
+
+    const Vector3& position() const;
+    const Quaternion& rotation() const;
+    float scale() const;
+
+    Children children() const;
 
     Magnum::Matrix4 computeTransformationMatrix() const;
     Transofrmation computeTransformation() const;
@@ -35,6 +69,10 @@ struct SceneNode {
     size_t numberOfLights() const;
 
     void print() const;
+
+private:
+    const FlatScene* m_scene;
+    NodeIndex m_index;
 };
 
 } // namespace parser
\ No newline at end of file
@@ -1,14 +1,13 @@
 #include "SceneParser.h"
 
-#include "BundleParser.h"
 #include "BinReader.h"
 #include "CommonPath.h"
 #include "Mesh.h"
-#include "PackageParser.h"
 #include "SceneNode.h"
+#include "SharkCache.h"
 #include "SharkNode.h"
-#include "SharkParser.h"
 #include "TextureParser.h"
+#include "VertexDecoder.h"
 
 #define STBI_ONLY_PNG
 #include <stb_image.h>
@@ -19,306 +18,404 @@
 
 namespace parser {
 
-const enum class ChannelType
-{
-    Unused,
-    Float2,
-    Float3,
-    Float4,
-    Color
-};
-const size_t entrySize[] = {0, 8, 12, 16, 4};
-const std::string entryName[] = {"Unused", "Float2", "Float3", "Float4", "Color"};
-const ChannelType entryType[] = {ChannelType::Unused, ChannelType::Float2, ChannelType::Float3, ChannelType::Float4, ChannelType::Color};
+// Enough for the tables of all but the largest meshes
+const size_t meshInfoArenaSize = 64 * 1024;
+
+// Appends one part to the mesh, its indices are rebased onto the vertices already in the mesh
+void appendMeshPart(const VertexLayout& layout, const char* vertices, size_t numVertices, std::span<const char> indices, Mesh& mesh) {
+    const uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+    decodeVertices(layout, vertices, numVertices, mesh);
+    mesh.indices.append(indices.data(), indices.size() / sizeof(uint16_t), baseVertex);
+}
+
+// Lamp glow meshes also add a point light colored like the texture of their first part
+bool isLight(const Mesh& mesh) {
+    return mesh.name.find("lampglow") != std::string::npos;
+}
 
-std::optional<Mesh>
-parseMesh(const StreamFormat& streamFormat, const std::vector<char>& verticesBuffer, const std::vector<char>& indicesBuffer) {
-    if (verticesBuffer.empty() || indicesBuffer.empty())
+std::optional<PointLight> loadLight(const Mesh& mesh) {
+    if (!isLight(mesh))
         return std::nullopt;
 
-    std::vector<ChannelType> channelTypes;
-    int bytePerVertex = 0;
-    for (int i = 0; i < 16; ++i) {
-        if (streamFormat.channel[i] != -1) {
-            bytePerVertex += entrySize[streamFormat.channel[i]];
-            channelTypes.push_back(entryType[streamFormat.channel[i]]);
-        }
+    if (mesh.meshParts.empty() || mesh.meshParts[0].textures.empty()) {
+        spdlog::warn("Light {} has no texture", mesh.name);
+        return std::nullopt;
     }
 
-    Mesh mesh;
-    if (channelTypes[0] == ChannelType::Float3 && channelTypes[1] == ChannelType::Float3 && channelTypes[2] == ChannelType::Float2) {
-        BinReaderMemory verticesReader(verticesBuffer.data(), verticesBuffer.size());
-        for (int vi = 0; vi < verticesBuffer.size() / bytePerVertex; ++vi) {
-            verticesReader.setPosition(vi * bytePerVertex);
-            Vector3 position = verticesReader.read<Vector3>();
-            Vector3 normal = verticesReader.read<Vector3>();
-            Vector2 uv = verticesReader.read<Vector2>();
-            mesh.vertices.push_back(position);
-            mesh.normals.push_back(normal);
-            mesh.uvs.push_back(Vector2{uv.x, 1.0f - uv.y});
-        }
+    const auto& texturePath = mesh.meshParts[0].textures[0];
+
+    int x, y, component;
+    unsigned char* data = stbi_load(texturePath.string().c_str(), &x, &y, &component, 0);
+    if (data == nullptr) {
+        spdlog::warn("Light {}: {} not loaded", mesh.name, texturePath.string());
+        return std::nullopt;
     }
-    else if (channelTypes[0] == ChannelType::Float3 && channelTypes[1] == ChannelType::Float3 && channelTypes[2] == ChannelType::Color &&
-             channelTypes[3] == ChannelType::Float2) {
-        BinReaderMemory verticesReader(verticesBuffer.data(), verticesBuffer.size());
-        for (int vi = 0; vi < verticesBuffer.size() / bytePerVertex; ++vi) {
-            verticesReader.setPosition(vi * bytePerVertex);
-            Vector3 position = verticesReader.read<Vector3>();
-            Vector3 normal = verticesReader.read<Vector3>();
-            int32_t color = verticesReader.read<int32_t>();
-            Vector2 uv = verticesReader.read<Vector2>();
-            mesh.vertices.push_back(position);
-            mesh.normals.push_back(normal);
-            mesh.uvs.push_back(Vector2{uv.x, 1.0f - uv.y});
-        }
+
+    int numberOfPixels = x * y;
+    Vector3 averageColor{0.0, 0.0, 0.0};
+    for (int i = 0; i < numberOfPixels; ++i) {
+        averageColor.x += data[i * 4 + 0];
+        averageColor.y += data[i * 4 + 1];
+        averageColor.z += data[i * 4 + 2];
     }
-    else if (channelTypes[0] == ChannelType::Float3 && channelTypes[1] == ChannelType::Float2) {
-        BinReaderMemory verticesReader(verticesBuffer.data(), verticesBuffer.size());
-        for (int vi = 0; vi < verticesBuffer.size() / bytePerVertex; ++vi) {
-            verticesReader.setPosition(vi * bytePerVertex);
-            Vector3 position = verticesReader.read<Vector3>();
-            Vector2 uv = verticesReader.read<Vector2>();
-            mesh.vertices.push_back(position);
-            mesh.uvs.push_back(Vector2{uv.x, 1.0f - uv.y});
-        }
+    stbi_image_free(data);
+
+    averageColor.x /= numberOfPixels;
+    averageColor.y /= numberOfPixels;
+    averageColor.z /= numberOfPixels;
+
+    Vector3 bmin = mesh.vertices[0];
+    Vector3 bmax = mesh.vertices[0];
+    for (const Vector3& v : mesh.vertices) {
+        bmin.x = std::min(bmin.x, v.x);
+        bmin.y = std::min(bmin.y, v.y);
+        bmin.z = std::min(bmin.z, v.z);
+        bmax.x = std::max(bmax.x, v.x);
+        bmax.y = std::max(bmax.y, v.y);
+        bmax.z = std::max(bmax.z, v.z);
     }
-    else if (channelTypes[0] == ChannelType::Float3 && channelTypes[1] == ChannelType::Color && channelTypes[2] == ChannelType::Float2) {
-        BinReaderMemory verticesReader(verticesBuffer.data(), verticesBuffer.size());
-        for (int vi = 0; vi < verticesBuffer.size() / bytePerVertex; ++vi) {
-            verticesReader.setPosition(vi * bytePerVertex);
-            Vector3 position = verticesReader.read<Vector3>();
-            int32_t color = verticesReader.read<int32_t>();
-            Vector2 uv = verticesReader.read<Vector2>();
-            mesh.vertices.push_back(position);
-            mesh.uvs.push_back(Vector2{uv.x, 1.0f - uv.y});
+
+    Vector3 center{0.5f * (bmin.x + bmax.x), 0.5f * (bmin.y + bmax.y), 0.5f * (bmin.z + bmax.z)};
+    float intencity = std::max(bmax.x - bmin.x, std::max(bmax.y - bmin.y, bmax.z - bmin.z)) * 10;
+
+    return PointLight{averageColor, center, intencity};
+}
+
+void runTextureJobs(const std::vector<TextureJob>& textureJobs, FlatScene& scene) {
+    for (const TextureJob& job : textureJobs) {
+        Mesh& mesh = *scene.mesh(job.node);
+        parseTextures(mesh.meshParts[job.part], job.textures, job.exportFolder);
+        if (job.part == 0 && isLight(mesh)) {
+            if (auto light = loadLight(mesh))
+                scene.setLight(job.node, *light);
         }
     }
-    else {
-        return std::nullopt;
-    }
+}
+
+namespace {
 
-    BinReaderMemory indicesReader(indicesBuffer.data(), indicesBuffer.size());
-    for (size_t i = 0; i < indicesBuffer.size() / sizeof(uint16_t); ++i)
-        mesh.indices.push_back(indicesReader.read<uint16_t>());
+// Entries loadHierarchy reads on every node, resolved once per SIR document
+struct HierarchyPaths {
+    SharkPath transl;
+    SharkPath quat;
+    SharkPath name;
+    SharkPath childArray;
+};
+
+// Node of the hierarchy whose children loadHierarchy is still loading
+struct OpenHierarchyNode {
+    const SharkNode* childArray;
+    NodeIndex index;
+    size_t nextChild;
+    bool isMeshLoaded;
+};
 
-    return mesh;
+OpenHierarchyNode beginHierarchyNode(const SharkNode* node,
+                                     const HierarchyPaths& paths,
+                                     FlatScene& scene,
+                                     NodeIndex parent,
+                                     const std::function<bool(const SharkNode* node, NodeIndex index)>& loadNode) {
+    Vector3 nodePosition{0.0f, 0.0f, 0.0f};
+    std::span<const float> position = getEntryValues<float>(node, paths.transl);
+    if (position.size() >= 3)
+        nodePosition = Vector3{position[0], position[1], position[2]};
+    Quaternion nodeRotation{0.0f, 0.0f, 0.0f, 1.0f};
+    std::span<const float> rotation = getEntryValues<float>(node, paths.quat);
+    if (rotation.size() >= 4)
+        nodeRotation = Quaternion{rotation[0], rotation[1], rotation[2], rotation[3]};
+
+    const std::string name = *getEntryValue<std::string>(node, paths.name);
+    OpenHierarchyNode open{node->goSub(paths.childArray), scene.beginNode(parent, name, nodePosition, nodeRotation, 1.0f), 0, false};
+    open.isMeshLoaded = loadNode(node, open.index);
+    return open;
 }
 
-void printFormat(StreamFormat& streamFormat) {
-    spdlog::enable_backtrace(16);
-    for (int ch = 0; ch < 16; ch++) {
-        if (streamFormat.channel[ch] != -1)
-            spdlog::debug(entryName[streamFormat.channel[ch]]);
-    }
-    spdlog::dump_backtrace();
+} // namespace
+
+bool loadHierarchy(const SharkNode* root, FlatScene& scene, const std::function<bool(const SharkNode* node, NodeIndex index)>& loadNode) {
+    if (root == nullptr)
+        return false;
+
+    const SharkDocument& document = *root->document;
+    const HierarchyPaths paths{SharkPath(document, "transl"),
+                               SharkPath(document, "quat"),
+                               SharkPath(document, "name"),
+                               SharkPath(document, "child_array")};
+
+    std::vector<OpenHierarchyNode> openNodes;
+    openNodes.push_back(beginHierarchyNode(root, paths, scene, noNode, loadNode));
+    while (true) {
+        OpenHierarchyNode& open = openNodes.back();
+        if (open.childArray != nullptr && open.nextChild < open.childArray->count()) {
+            const SharkNode* child = open.childArray->at(static_cast<int>(open.nextChild++));
+            if (child != nullptr)
+                openNodes.push_back(beginHierarchyNode(child, paths, scene, open.index, loadNode));
+            continue;
+        }
 
-    spdlog::enable_backtrace(16);
-    for (int ch = 0; ch < 16; ch++) {
-        if (streamFormat.channel[ch] != -1)
-            spdlog::debug(entrySize[streamFormat.channel[ch]]);
+        scene.endNode(open.index);
+        const bool isMeshLoaded = open.isMeshLoaded;
+        // Subtrees without meshes are dropped, they are the last nodes of the scene at this point
+        if (!isMeshLoaded)
+            scene.truncate(open.index);
+        openNodes.pop_back();
+        if (openNodes.empty())
+            return isMeshLoaded;
+        if (isMeshLoaded)
+            openNodes.back().isMeshLoaded = true;
     }
-    spdlog::dump_backtrace();
 }
 
-SceneParser::SceneParser(const SirEntry& sirEntry, const std::string& bundleName)
-        : sceneRoot(std::nullopt)
-        , m_sirEntry(sirEntry) {
-    loadScene(sirEntry.sirPath, bundleName);
+SceneParser::SceneParser(const SirEntry& sirEntry, Bundle& bundle, bool deferTextures)
+        : flatScene(std::nullopt)
+        , m_bundle(bundle)
+        , m_sirEntry(sirEntry)
+        , m_deferTextures(deferTextures)
+        , m_meshInfoBuffer(meshInfoArenaSize)
+        , m_meshInfoArena(m_meshInfoBuffer.data(), m_meshInfoBuffer.size(), &m_meshInfoUpstream) {
+    loadScene(sirEntry.sirPath);
 }
 
-void SceneParser::loadScene(const std::filesystem::path& sirPath, const std::string& bundleName) {
-    loadBundle(bundleName);
+void SceneParser::loadScene(const std::filesystem::path& sirPath) {
     addScene(sirPath);
-}
 
-void SceneParser::loadBundle(const std::string& bundleName) {
-    BundleParser bundleParser(bundlesFolderPath / (bundleName + ".bun"));
-    m_bundleName = bundleName;
-    m_bundleHeader = bundleParser.parseHeader();
+    spdlog::debug("{}: {} meshes decoded, {} MeshInfo allocations ({} bytes) past the arena buffer",
+                  sirPath.string(),
+                  m_numDecodedMeshes,
+                  m_meshInfoUpstream.allocations(),
+                  m_meshInfoUpstream.bytes());
 }
 
 void SceneParser::addScene(const std::filesystem::path& sirPath) {
-    sceneRoot = loadSir(sirPath);
+    flatScene = loadSir(sirPath);
 }
 
-std::optional<SceneNode> SceneParser::loadSir(const std::filesystem::path& sirPath) {
+std::optional<FlatScene> SceneParser::loadSir(const std::filesystem::path& sirPath) {
     spdlog::info("Parsing SIR {}...", sirPath.string());
-    SharkParser sharkParser(sirPath.string());
-    SharkNode* root = sharkParser.getRoot()->goSub("data/root");
-    if (root == nullptr) {
+    std::unique_ptr<SharkDocument> parsed;
+    const SharkDocument* document = m_sirEntry.hierarchy.get();
+    if (document == nullptr) {
+        parsed = readCachedDocument(sirPath, "data/root");
+        document = parsed.get();
+    }
+    if (document == nullptr) {
         spdlog::error("{} didn't contain 'data/root'", sirPath.string());
         return std::nullopt;
     }
 
+    m_modelPath = SharkPath(*document, "model");
+    m_shaderPath = SharkPath(*document, "shader");
+
     auto smrPath = sirPath;
     smrPath.replace_extension(".smr");
+    const std::string smrFile = smrPath.string();
 
-    auto parsedSir = loadHierarchy(root, smrPath.string(), m_sirEntry.filename);
-    if (parsedSir.has_value())
-        parsedSir->name = m_sirEntry.filename;
+    FlatScene scene;
+    auto loadNode = [&](const SharkNode* node, NodeIndex index) { return loadNodeMesh(node, smrFile, scene, index); };
+    if (!loadHierarchy(document->root(), scene, loadNode))
+        return std::nullopt;
 
-    return parsedSir;
+    scene.setName(0, m_sirEntry.filename);
+    return scene;
 }
 
-std::optional<SceneNode>
-SceneParser::loadHierarchy(SharkNode* node, const std::string& smrFile, const std::filesystem::path& hierarchyPath) {
-    if (node == nullptr)
-        return std::nullopt;
+bool SceneParser::loadNodeMesh(const SharkNode* node, const std::string& smrFile, FlatScene& scene, NodeIndex index) {
+    auto modelName = getEntryValue<std::string>(node, m_modelPath);
+    auto shader = getEntryValue<std::string>(node, m_shaderPath);
+    if (!modelName.has_value() || !shader.has_value())
+        return false;
+
+    spdlog::debug("Trying to load {} in {}", *modelName, smrFile);
+    float scale = 1.0f;
+    auto mesh = loadMesh(smrFile, *modelName, index, scale);
+    scene.setScale(index, scale);
+    if (!mesh.has_value())
+        return false;
+
+    // With deferred textures the light is added by runTextureJobs, once the texture it is colored by exists
+    auto light = m_deferTextures ? std::nullopt : loadLight(*mesh);
+    scene.setMesh(index, std::move(*mesh));
+    if (light.has_value())
+        scene.setLight(index, *light);
+    return true;
+}
 
-    bool isMmeshLoaded = false;
-    SceneNode sceneNode;
-    auto position = getEntryArray<float>(node, "transl");
-    if (position.has_value())
-        sceneNode.position = Vector3{position->at(0), position->at(1), position->at(2)};
-    else
-        sceneNode.position = Vector3{0.0f, 0.0f, 0.0f};
-    auto rotation = getEntryArray<float>(node, "quat");
-    if (rotation.has_value())
-        sceneNode.rotation = Quaternion{rotation->at(0), rotation->at(1), rotation->at(2), rotation->at(3)};
-    else
-        sceneNode.rotation = Quaternion{0.0f, 0.0f, 0.0f, 1.0f};
-    sceneNode.scale = 1.0f;
-
-    sceneNode.name = *getEntryValue<std::string>(node, "name");
-    auto modelName = getEntryValue<std::string>(node, "model");
-    auto shader = getEntryValue<std::string>(node, "shader");
-    if (modelName.has_value() && shader.has_value()) {
-        spdlog::debug("Trying to load {} in {}", *modelName, smrFile);
-        auto mesh = loadMesh(smrFile, *modelName, sceneNode.scale);
-        if (mesh.has_value()) {
-            isMmeshLoaded = true;
-            sceneNode.mesh = mesh;
-
-            sceneNode.light = loadLight(*mesh);
-        }
-    }
+std::optional<Mesh> SceneParser::loadMesh(const std::string& smrFile, const std::string& modelName, NodeIndex node, float& outScale) {
+    const BundleFileEntry* file = m_bundle.header().getFileEntry(smrFile);
+    if (file == nullptr || file->getMeshEntry(modelName) == nullptr)
+        return std::nullopt;
 
-    SharkNode* group = node->goSub("child_array");
-    if (group != nullptr) {
-        // sub_array ?
-        for (int i = 0; i < group->count(); ++i) {
-            auto child = loadHierarchy(group->at(i), smrFile, hierarchyPath / sceneNode.name);
-            if (child.has_value()) {
-                isMmeshLoaded = true;
-                sceneNode.children.push_back(*child);
-            }
+    MeshCache* meshCache = m_bundle.meshCache();
+    std::optional<MeshCacheView> cached = meshCache ? meshCache->find(smrFile, modelName) : std::nullopt;
+    DecodedMesh decodedMesh = cached.has_value() ? cached->materialize() : decodeMesh(smrFile, modelName);
+    m_meshInfoArena.release();
+    if (meshCache != nullptr && !cached.has_value())
+        meshCache->store(smrFile, modelName, decodedMesh);
+
+    if (decodedMesh.rescale.has_value())
+        outScale = *decodedMesh.rescale;
+
+    if (decodedMesh.mesh.has_value()) {
+        std::filesystem::path exportPath = std::filesystem::path("meshes/textures") / m_bundle.name();
+        for (size_t i = 0; i < decodedMesh.mesh->meshParts.size(); ++i) {
+            if (m_deferTextures)
+                textureJobs.push_back(TextureJob{node, i, std::move(decodedMesh.textures[i]), exportPath});
+            else
+                parseTextures(decodedMesh.mesh->meshParts[i], decodedMesh.textures[i], exportPath);
         }
     }
 
-    if (isMmeshLoaded || !sceneNode.children.empty())
-        return sceneNode;
-
-    return std::nullopt;
+    return std::move(decodedMesh.mesh);
 }
 
-std::optional<Mesh> SceneParser::loadMesh(const std::string& smrFile, const std::string& modelName, float& outScale) {
-    BinReaderMmap binReader(bundlesFolderPath / (m_bundleName + ".bun"));
+DecodedMesh SceneParser::decodeMesh(const std::string& smrFile, const std::string& modelName) {
+    BinReaderMmap binReader(bundlesFolderPath / (m_bundle.name() + ".bun"));
 
-    BundleHeader& header = m_bundleHeader;
-
-    BundleFileEntry* file = header.getFileEntry(smrFile);
-    if (file == nullptr)
-        return std::nullopt;
-
-    MeshEntry* meshEntry = file->getMeshEntry(modelName);
-    if (meshEntry == nullptr)
-        return std::nullopt;
+    const BundleHeader& header = m_bundle.header();
+    const MeshEntry* meshEntry = header.getFileEntry(smrFile)->getMeshEntry(modelName);
 
+    DecodedMesh decodedMesh;
     binReader.setZeroPos(header.posZero);
     binReader.setPosition(meshEntry->posStart + header.posZero);
-    MeshInfo info;
+    ++m_numDecodedMeshes;
+    MeshInfo info(&m_meshInfoArena);
     bool success = info.load(binReader);
     if (!success)
-        return std::nullopt;
+        return decodedMesh;
 
-    spdlog::debug("Load part0");
-    MeshPartInfo part = info.parts[0];
-    if (part.header.formatIdx == 0 || part.header.bitcode == 0 || part.header.numTextures == 0)
-        return std::nullopt;
+    Mesh mesh;
+    mesh.name = modelName;
+    mesh.smoothness = modelName.find("skydome") != std::string::npos;
+
+    // Frames after frame 0 of every animated part, merged by frame number and quantized once all parts are in
+    struct FrameDeltas {
+        float key = 0.0f;
+        std::vector<uint32_t> vertices;
+        std::vector<Vector3> deltas;
+    };
+    std::vector<FrameDeltas> frames;
+
+    // Every part with vertex data owns numAnim consecutive vertex data entries, one per animation frame
+    int dataIndex = meshEntry->dataIndex;
+    for (size_t partIndex = 0; partIndex < info.parts.size(); ++partIndex) {
+        const MeshPartInfo& part = info.parts[partIndex];
+        if (part.header.formatIdx == 0 || part.header.bitcode == 0)
+            continue;
+
+        const int64_t numFileEntries = static_cast<int64_t>(header.fileEntries.size());
+        const int64_t formatIndex = (static_cast<int64_t>(part.header.formatIdx / 4) - numFileEntries - 3) / 18;
+        if (formatIndex < 0 || formatIndex >= static_cast<int64_t>(header.streamFormats.size())) {
+            spdlog::warn("{}: part {} has no vertex format {}, skipped", modelName, partIndex, formatIndex);
+            continue;
+        }
+        const StreamFormat& format = header.streamFormats[formatIndex];
+        if (format.size == 0)
+            continue;
+
+        const int partDataIndex = dataIndex;
+        dataIndex += part.header.numAnim;
+        if (part.header.numTextures == 0 || part.header.numAnim <= 0)
+            continue;
+        if (partDataIndex < 0 || dataIndex > static_cast<int64_t>(header.dataHeader.size())) {
+            spdlog::warn("{}: vertex data {}..{} of part {} is out of the bundle header, skipped",
+                         modelName,
+                         partDataIndex,
+                         dataIndex,
+                         partIndex);
+            continue;
+        }
+        const VertexDataHeader& data = header.dataHeader[partDataIndex];
+
+        decodedMesh.rescale = info.header.rescale;
+
+        const VertexLayout& layout = m_bundle.vertexLayouts()[formatIndex];
+        spdlog::debug("Loading part {} of {}, vertex format: {}", partIndex, modelName, layout.name());
+        int patchVertices = part.header.numVertices / part.header.numAnim;
+        if (data.vertexSize == 0 || data.length / data.vertexSize != patchVertices || data.vertexSize / 4 != format.size) {
+            spdlog::warn("{}: part {} doesn't match its vertex data (length {}, vertex size {}, {} vertices, format size {}), skipped",
+                         modelName,
+                         partIndex,
+                         data.length,
+                         data.vertexSize,
+                         patchVertices,
+                         format.size);
+            continue;
+        }
 
-    outScale = info.header.rescale;
-    int formatIndex = (part.header.formatIdx / 4 - header.fileEntries.size() - 3) / 18;
-    if (header.streamFormats[formatIndex].size == 0)
-        return std::nullopt;
+        if (!layout.isSupported()) {
+            spdlog::warn("{}: vertex format {} of part {} has no position, skipped", modelName, layout.name(), partIndex);
+            continue;
+        }
+        if (part.indices.empty() || patchVertices == 0)
+            continue;
+
+        if (data.posStart + data.length > binReader.size()) {
+            spdlog::error("{}: vertex data of part {} is out of the bundle", modelName, partIndex);
+            continue;
+        }
+
+        // Vertices are decoded straight from the mapped bundle
+        int vOffset = static_cast<int>(mesh.vertices.size());
+        int iOffset = static_cast<int>(mesh.indices.size());
+        appendMeshPart(layout, binReader.data() + data.posStart, patchVertices, part.indices, mesh);
+        if (part.header.numBoneStages > 0 && !info.boneNames.empty())
+            mesh.skin.appendPart(info, part, vOffset, patchVertices);
+
+        for (int frame = 1; frame < part.header.numAnim; ++frame) {
+            const VertexDataHeader& frameData = header.dataHeader[partDataIndex + frame];
+            if (frameData.length != data.length || frameData.posStart + frameData.length > binReader.size()) {
+                spdlog::warn("{}: frame {} of part {} doesn't match frame 0, skipped", modelName, frame, partIndex);
+                continue;
+            }
+
+            if (frames.size() < static_cast<size_t>(frame))
+                frames.resize(frame);
+            FrameDeltas& frameDeltas = frames[frame - 1];
+            if (static_cast<size_t>(frame) < part.animKeys.size())
+                frameDeltas.key = part.animKeys[frame];
+            decodePositionDeltas(layout,
+                                 binReader.data() + frameData.posStart,
+                                 patchVertices,
+                                 mesh.vertices.data() + vOffset,
+                                 vOffset,
+                                 frameDeltas.vertices,
+                                 frameDeltas.deltas);
+        }
 
-    spdlog::debug("Loading vertex data");
-    StreamFormat& format = header.streamFormats[formatIndex];
-    // printFormat(format);
-    VertexDataHeader& data = header.dataHeader[meshEntry->dataIndex];
-    int patchVertices = part.header.numVertices / part.header.numAnim;
-    if (data.length / data.vertexSize != patchVertices || data.vertexSize / 4 != format.size)
-        throw new std::runtime_error("len mismatch : entlen " + std::to_string(data.length) + " entpos " + std::to_string(data.posStart) +
-                                     " entsize " + std::to_string(data.vertexSize) + " verts " + std::to_string(patchVertices) +
-                                     " frmtsize " + std::to_string(format.size));
-
-    binReader.setPosition(data.posStart);
-    std::vector<char> vertices = binReader.readChars(4 * format.size * patchVertices);
-
-    auto mesh = parseMesh(format, vertices, part.indices);
-    if (mesh.has_value()) {
-        mesh->name = modelName;
-        if (modelName.find("skydome") != std::string::npos)
-            mesh->smoothness = true;
-
-        mesh->meshParts.resize(part.header.numTexStages);
-        int vOffset = 0;
-        int iOffset = 0;
         for (int i = 0; i < part.header.numTexStages; ++i) {
             std::vector<std::filesystem::path> texturePath(part.header.numTextures);
             for (int l = 0; l < part.header.numTextures; ++l) {
                 texturePath[l] = (part.tex[l].texIdx[i] == -1) ? "" : header.textures[info.texIdx[part.tex[l].texIdx[i]]];
             }
-            std::filesystem::path exportPath = std::filesystem::path("meshes/textures") / m_bundleName;
-            parseTextures(mesh->meshParts[i], texturePath, exportPath);
+            decodedMesh.textures.push_back(std::move(texturePath));
 
-            mesh->meshParts[i].vertexInterval = std::pair(vOffset, vOffset + part.stageVertices[i]);
-            mesh->meshParts[i].indexInterval = std::pair(iOffset, iOffset + part.stageIndices[i]);
+            MeshPart& meshPart = mesh.meshParts.emplace_back();
+            meshPart.vertexInterval = std::pair(vOffset, vOffset + part.stageVertices[i]);
+            meshPart.indexInterval = std::pair(iOffset, iOffset + part.stageIndices[i]);
             vOffset += part.stageVertices[i];
             iOffset += part.stageIndices[i];
         }
     }
 
-    return mesh;
-}
-
-std::optional<PointLight> SceneParser::loadLight(const Mesh& mesh) {
-    if (mesh.name.find("lampglow") == std::string::npos)
-        return std::nullopt;
-
-    assert(!mesh.meshParts.empty() && !mesh.meshParts[0].textures.empty());
-
-    const auto& texturePath = mesh.meshParts[0].textures[0];
-
-    int x, y, component;
-    unsigned char* data = stbi_load(texturePath.string().c_str(), &x, &y, &component, 0);
-    int numberOfPixels = x * y;
-    Vector3 averageColor{0.0, 0.0, 0.0};
-    for (int i = 0; i < numberOfPixels; ++i) {
-        averageColor.x += data[i * 4 + 0];
-        averageColor.y += data[i * 4 + 1];
-        averageColor.z += data[i * 4 + 2];
-    }
-    stbi_image_free(data);
-
-    averageColor.x /= numberOfPixels;
-    averageColor.y /= numberOfPixels;
-    averageColor.z /= numberOfPixels;
-
-    Vector3 bmin = mesh.vertices[0];
-    Vector3 bmax = mesh.vertices[0];
-    for (const Vector3& v : mesh.vertices) {
-        bmin.x = std::min(bmin.x, v.x);
-        bmin.y = std::min(bmin.y, v.y);
-        bmin.z = std::min(bmin.z, v.z);
-        bmax.x = std::max(bmax.x, v.x);
-        bmax.y = std::max(bmax.y, v.y);
-        bmax.z = std::max(bmax.z, v.z);
+    if (!frames.empty()) {
+        size_t framesSize = 0;
+        for (const FrameDeltas& frameDeltas : frames) {
+            mesh.morphFrames.push_back(MorphFrame::build(frameDeltas.key, frameDeltas.vertices, frameDeltas.deltas));
+            framesSize += mesh.morphFrames.back().memorySize();
+        }
+        spdlog::debug("{}: {} morph frames, {} bytes per frame, {} bytes as full positions",
+                      modelName,
+                      frames.size(),
+                      framesSize / frames.size(),
+                      mesh.vertices.size() * sizeof(Vector3));
     }
 
-    Vector3 center{0.5f * (bmin.x + bmax.x), 0.5f * (bmin.y + bmax.y), 0.5f * (bmin.z + bmax.z)};
-    float intencity = std::max(bmax.x - bmin.x, std::max(bmax.y - bmin.y, bmax.z - bmin.z)) * 10;
+    if (!mesh.skin.empty())
+        mesh.skin.vertices.resize(mesh.vertices.size(), SkinVertex{});
 
-    return PointLight{averageColor, center, intencity};
+    if (!mesh.vertices.empty())
+        decodedMesh.mesh = std::move(mesh);
+    return decodedMesh;
 }
 
 } // namespace parser
\ No newline at end of file
@@ -1,34 +1,68 @@
 #pragma once
 
-#include "BundleHeader.h"
+#include "Bundle.h"
+#include "MemoryStats.h"
 #include "SceneIndex.h"
 #include "SceneNode.h"
+#include "SharkNode.h"
 
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <memory_resource>
 
 namespace parser {
 
-struct SharkNode;
+// Conversion of the textures of one mesh part, see SceneParser::textureJobs
+struct TextureJob {
+    NodeIndex node;
+    size_t part;
+    std::vector<std::filesystem::path> textures; // bundle texture paths
+    std::filesystem::path exportFolder;
+};
+
+// Converts the textures and fills in the mesh parts they belong to, and adds the lights colored by them
+void runTextureJobs(const std::vector<TextureJob>& textureJobs, FlatScene& scene);
+
+// Adds the SIR hierarchy below `root` to the scene: every node with its transform and name, then `loadNode` loads what
+// it holds and tells whether that was a mesh. Subtrees without meshes are dropped, returns whether a mesh was loaded.
+// Walks the SIR with an explicit stack, deep hierarchies don't depend on the stack size of the thread.
+bool loadHierarchy(const SharkNode* root, FlatScene& scene, const std::function<bool(const SharkNode* node, NodeIndex index)>& loadNode);
 
 class SceneParser {
 public:
-    SceneParser(const SirEntry& sirEntry, const std::string& bundleName);
+    // Parses the SIR against a bundle loaded once for several SIRs. The caller flushes the mesh cache of the bundle
+    // once, after its last SIR.
+    // With `deferTextures` the textures aren't converted while parsing but left in textureJobs.
+    SceneParser(const SirEntry& sirEntry, Bundle& bundle, bool deferTextures = false);
 
-    std::optional<SceneNode> sceneRoot;
+    std::optional<FlatScene> flatScene;
+    std::vector<TextureJob> textureJobs;
 
 private:
-    void loadScene(const std::filesystem::path& sirPath, const std::string& bundleName);
-    void loadBundle(const std::string& bundleName);
+    void loadScene(const std::filesystem::path& sirPath);
     void addScene(const std::filesystem::path& sirPath);
 
-    std::optional<SceneNode> loadSir(const std::filesystem::path& sirPath);
-    std::optional<SceneNode> loadHierarchy(SharkNode* node, const std::string& smrFile, const std::filesystem::path& hierarchyPath);
-    std::optional<Mesh> loadMesh(const std::string& smrFile, const std::string& modelName, float& outScale);
-    std::optional<PointLight> loadLight(const Mesh& mesh);
+    std::optional<FlatScene> loadSir(const std::filesystem::path& sirPath);
+    // Whether the node of the hierarchy has a mesh, its light is added with it
+    bool loadNodeMesh(const SharkNode* node, const std::string& smrFile, FlatScene& scene, NodeIndex index);
+    std::optional<Mesh> loadMesh(const std::string& smrFile, const std::string& modelName, NodeIndex node, float& outScale);
+    DecodedMesh decodeMesh(const std::string& smrFile, const std::string& modelName);
 
-    BundleHeader m_bundleHeader;
-    std::string m_bundleName;
+    Bundle& m_bundle;
     const SirEntry& m_sirEntry;
+    bool m_deferTextures = false;
+
+    // Entries loadNodeMesh reads on every node, resolved once per SIR document
+    SharkPath m_modelPath;
+    SharkPath m_shaderPath;
+
+    // MeshInfo tables of the mesh being decoded, released after every mesh.
+    // Only meshes that outgrow the initial buffer reach m_meshInfoUpstream.
+    std::vector<std::byte> m_meshInfoBuffer;
+    CountingResource m_meshInfoUpstream;
+    std::pmr::monotonic_buffer_resource m_meshInfoArena;
+    size_t m_numDecodedMeshes = 0;
 };
 
 } // namespace parser
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "SceneTransforms.h"
+#include "FlatScene.h"
+
+#include <cmath>
+
+namespace parser {
+
+namespace {
+
+// Tolerance of Magnum's Quaternion::isNormalized() on the squared length
+const float normalizedTolerance = 2.0e-5f;
+
+} // namespace
+
+void computeTransforms(const FlatScene& scene, SceneTransforms& transforms) {
+    const size_t size = scene.size();
+    std::span<const Quaternion> rotations = scene.rotations();
+    std::span<const Vector3> positions = scene.positions();
+    std::span<const float> scales = scene.scales();
+    std::span<const NodeIndex> parents = scene.parents();
+
+    // Normalization hoisted out of the matrix loop: an unnormalized rotation scales the node by its squared length.
+    // The position is rotated by the inverse rotation and back again, so it ends up only scaled.
+    std::vector<float> nodeScales(size);
+    std::vector<Quaternion> nodeRotations(size);
+    for (size_t i = 0; i < size; ++i) {
+        const Quaternion& q = rotations[i];
+        const float dot = q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w;
+        const bool isNormalized = std::abs(dot - 1.0f) < normalizedTolerance;
+        const float factor = isNormalized ? 1.0f : 1.0f / std::sqrt(dot);
+        nodeScales[i] = (isNormalized ? 1.0f : dot) / scales[i];
+        nodeRotations[i] = Quaternion{q.x * factor, q.y * factor, q.z * factor, q.w * factor};
+    }
+
+    transforms.local.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        const float s = nodeScales[i];
+        const float x = nodeRotations[i].x, y = nodeRotations[i].y, z = nodeRotations[i].z, w = nodeRotations[i].w;
+        const Vector3& p = positions[i];
+        // Columns of scaling * rotation * translation
+        transforms.local[i] = Magnum::Matrix4{
+            Magnum::Vector4{s * (1.0f - 2.0f * (y * y + z * z)), s * 2.0f * (x * y + z * w), s * 2.0f * (x * z - y * w), 0.0f},
+            Magnum::Vector4{s * 2.0f * (x * y - z * w), s * (1.0f - 2.0f * (x * x + z * z)), s * 2.0f * (y * z + x * w), 0.0f},
+            Magnum::Vector4{s * 2.0f * (x * z + y * w), s * 2.0f * (y * z - x * w), s * (1.0f - 2.0f * (x * x + y * y)), 0.0f},
+            Magnum::Vector4{s * p.x, s * p.y, s * p.z, 1.0f}};
+    }
+
+    transforms.world.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        const NodeIndex parent = parents[i];
+        transforms.world[i] = parent == noNode ? transforms.local[i] : transforms.world[parent] * transforms.local[i];
+    }
+}
+
+} // namespace parser
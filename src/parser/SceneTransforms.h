@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include <vector>
+
+namespace parser {
+
+class FlatScene;
+
+// Local and world matrices of every node of a FlatScene, indexed like its nodes
+struct SceneTransforms {
+    std::vector<Magnum::Matrix4> local;
+    std::vector<Magnum::Matrix4> world;
+};
+
+// Same matrices as SceneNode::computeTransformationMatrix, computed for the whole scene in a few flat passes.
+// Parents come before their children, so a single sweep composes the world matrices.
+void computeTransforms(const FlatScene& scene, SceneTransforms& transforms);
+
+} // namespace parser
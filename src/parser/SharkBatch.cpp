@@ -0,0 +1,76 @@
+#include "SharkBatch.h"
+#include "BinReader.h"
+#include "PackageParser.h"
+#include "SharkReader.h"
+#include "ThreadPool.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+namespace parser {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Written by one job only
+struct FileStats {
+    size_t numBytes = 0;
+    double seconds = 0.0;
+};
+
+} // namespace
+
+SharkBatch parseSharkFiles(const std::vector<std::filesystem::path>& paths, ThreadPool& pool, std::string_view subtree) {
+    const auto start = Clock::now();
+    SharkBatch batch;
+    batch.documents.resize(paths.size());
+    std::vector<FileStats> fileStats(paths.size());
+
+    auto parseFile = [&](size_t i) {
+        const auto fileStart = Clock::now();
+        try {
+            std::shared_ptr<BinReaderMmap> file = PackageParser::instance().openEntry(paths[i]);
+            if (file == nullptr)
+                file = std::make_shared<BinReaderMmap>(paths[i]);
+            fileStats[i].numBytes = file->size();
+
+            SharkReader reader(std::move(file));
+            batch.documents[i] = subtree.empty() ? reader.readAll() : reader.read(subtree);
+        }
+        catch (const std::exception& e) {
+            spdlog::error("Can't parse {}: {}", paths[i].string(), e.what());
+        }
+        fileStats[i].seconds = secondsSince(fileStart);
+    };
+
+    ThreadPool::Group group;
+    for (size_t i = 0; i < paths.size(); ++i)
+        pool.submit([&parseFile, i] { parseFile(i); }, group);
+    pool.wait(group);
+
+    SharkBatchStats& stats = batch.stats;
+    stats.numFiles = paths.size();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        stats.numBytes += fileStats[i].numBytes;
+        stats.parseSeconds += fileStats[i].seconds;
+        if (batch.documents[i] == nullptr)
+            ++stats.numFailed;
+        else
+            stats.numNodes += batch.documents[i]->numberOfNodes();
+    }
+    stats.wallSeconds = secondsSince(start);
+    spdlog::debug("{} shark3d files parsed in {:.3f} s on {} threads, {} failed",
+                  stats.numFiles,
+                  stats.wallSeconds,
+                  pool.size(),
+                  stats.numFailed);
+    return batch;
+}
+
+} // namespace parser
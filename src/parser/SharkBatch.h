@@ -0,0 +1,35 @@
+#pragma once
+
+#include "SharkNode.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace parser {
+
+class ThreadPool;
+
+struct SharkBatchStats {
+    size_t numFiles = 0;
+    size_t numFailed = 0;
+    size_t numBytes = 0;
+    size_t numNodes = 0;
+    double wallSeconds = 0.0;
+    double parseSeconds = 0.0; // summed over the jobs
+};
+
+struct SharkBatch {
+    std::vector<std::unique_ptr<SharkDocument>> documents; // in the order of the paths, nullptr if a file failed or lacks the subtree
+    SharkBatchStats stats;
+};
+
+// Parses the files on `pool`, one job per file, then waits for these jobs only. The caller runs queued jobs of the pool
+// meanwhile, so it may be a worker of the pool itself. Files are mapped inside their .pak instead of
+// extracted and every job has its own reader, so the jobs share no mutable state. `subtree` is read like
+// SharkReader::read does, the whole files if it is empty.
+SharkBatch parseSharkFiles(const std::vector<std::filesystem::path>& paths, ThreadPool& pool, std::string_view subtree = {});
+
+} // namespace parser
@@ -0,0 +1,276 @@
+#include "SharkCache.h"
+#include "BinReader.h"
+#include "CommonPath.h"
+#include "SharkReader.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+// Cache file layout, all little-endian:
+//   SharkCacheHeader
+//   CachedSharkNode[numNodes]   SharkNode without the document pointer
+//   int64_t[numInts]
+//   float[numFloats]
+//   uint32_t[numStringIds]
+//   CachedAtom[numAtoms]         ranges of the characters below
+//   char[]                       every atom once, without terminators
+// Sections are 8-byte aligned.
+
+namespace parser {
+
+namespace {
+
+const char cacheMagic[8] = {'D', 'T', 'L', 'J', 'S', 'H', 'R', 'K'};
+const uint32_t cacheVersion = 1;
+const size_t sectionAlignment = 8;
+
+struct SharkCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t pakStamp;
+    uint32_t sourceOffset;
+    int32_t sourceSize;
+    uint32_t numNodes;
+    uint32_t numInts;
+    uint32_t numFloats;
+    uint32_t numStringIds;
+    uint32_t numAtoms;
+    uint32_t numChars;
+    uint64_t nodesOffset;
+    uint64_t intsOffset;
+    uint64_t floatsOffset;
+    uint64_t stringIdsOffset;
+    uint64_t atomsOffset;
+    uint64_t charsOffset;
+    uint64_t fileSize;
+};
+
+struct CachedSharkNode {
+    uint32_t type;
+    uint32_t nameId;
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct CachedAtom {
+    uint32_t offset;
+    uint32_t length;
+};
+
+size_t alignUp(size_t value) {
+    return (value + sectionAlignment - 1) & ~(sectionAlignment - 1);
+}
+
+template <typename T>
+std::span<const T> section(const BinReader& file, uint64_t offset, uint32_t count) {
+    return std::span<const T>(reinterpret_cast<const T*>(file.data() + offset), count);
+}
+
+// Whether a section lies in the file and is aligned for its values
+bool isSectionInFile(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t fileSize) {
+    return offset % sectionAlignment == 0 && offset <= fileSize && count * itemSize <= fileSize - offset;
+}
+
+bool isInPool(uint32_t offset, uint32_t length, uint32_t poolSize) {
+    return static_cast<uint64_t>(offset) + length <= poolSize;
+}
+
+bool areSectionsValid(const SharkCacheHeader& header) {
+    return header.numNodes > 0 && isSectionInFile(header.nodesOffset, header.numNodes, sizeof(CachedSharkNode), header.fileSize) &&
+           isSectionInFile(header.intsOffset, header.numInts, sizeof(int64_t), header.fileSize) &&
+           isSectionInFile(header.floatsOffset, header.numFloats, sizeof(float), header.fileSize) &&
+           isSectionInFile(header.stringIdsOffset, header.numStringIds, sizeof(uint32_t), header.fileSize) &&
+           isSectionInFile(header.atomsOffset, header.numAtoms, sizeof(CachedAtom), header.fileSize) &&
+           isSectionInFile(header.charsOffset, header.numChars, sizeof(char), header.fileSize);
+}
+
+// Values are read from the pools without checks, so every range is checked once here. Children and elements follow
+// their parent, as the reader appends them, which also keeps a corrupt cache from making a cycle.
+bool isNodeValid(const CachedSharkNode& node, uint32_t index, const SharkCacheHeader& header) {
+    if (node.nameId >= header.numAtoms)
+        return false;
+
+    switch (static_cast<SharkNodeType>(node.type)) {
+    case SharkNodeType::Empty:
+        return true;
+    case SharkNodeType::Int:
+    case SharkNodeType::ArrayInt:
+        return isInPool(node.offset, node.length, header.numInts);
+    case SharkNodeType::Float:
+    case SharkNodeType::ArrayFloat:
+        return isInPool(node.offset, node.length, header.numFloats);
+    case SharkNodeType::String:
+    case SharkNodeType::ArrayString:
+        return isInPool(node.offset, node.length, header.numStringIds);
+    case SharkNodeType::Sub:
+    case SharkNodeType::ArraySub:
+        return (node.length == 0 || node.offset > index) && isInPool(node.offset, node.length, header.numNodes);
+    }
+    return false;
+}
+
+template <typename T>
+void writeSection(std::ofstream& out, uint64_t offset, const T* values, size_t count) {
+    const char padding[sectionAlignment] = {};
+    out.write(padding, offset - static_cast<uint64_t>(out.tellp()));
+    out.write(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+} // namespace
+
+std::unique_ptr<SharkDocument> SharkCache::load(const std::filesystem::path& cachePath, const PackageSource& source) {
+    std::error_code error;
+    if (!std::filesystem::exists(cachePath, error) || std::filesystem::file_size(cachePath, error) < sizeof(SharkCacheHeader))
+        return nullptr;
+
+    auto file = std::make_shared<BinReaderMmap>(cachePath);
+    if (!file->isOpen())
+        return nullptr;
+
+    const SharkCacheHeader* header = reinterpret_cast<const SharkCacheHeader*>(file->data());
+    bool isValid = std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) == 0 && header->version == cacheVersion &&
+                   header->fileSize == file->size() && header->pakStamp == source.pakStamp &&
+                   header->sourceOffset == source.offset && header->sourceSize == source.size;
+    if (!isValid) {
+        spdlog::debug("Shark cache {} is stale", cachePath.string());
+        return nullptr;
+    }
+
+    // A corrupt cache is parsed again like a stale one
+    auto corrupt = [&cachePath] {
+        spdlog::warn("Shark cache {} is corrupt, it will be rebuilt", cachePath.string());
+        return nullptr;
+    };
+    if (!areSectionsValid(*header))
+        return corrupt();
+
+    auto document = std::make_unique<SharkDocument>();
+    auto nodes = section<CachedSharkNode>(*file, header->nodesOffset, header->numNodes);
+    if (nodes[0].type != SharkNodeType::Sub)
+        return corrupt();
+    document->m_nodes.resize(nodes.size());
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        const CachedSharkNode& node = nodes[i];
+        if (!isNodeValid(node, i, *header))
+            return corrupt();
+        document->m_nodes[i] =
+            SharkNode{static_cast<SharkNodeType>(node.type), node.nameId, node.offset, node.length, document.get()};
+    }
+
+    // Values are used in place, the document keeps the file mapped
+    auto stringIds = section<uint32_t>(*file, header->stringIdsOffset, header->numStringIds);
+    if (std::any_of(stringIds.begin(), stringIds.end(), [&](uint32_t stringId) { return stringId >= header->numAtoms; }))
+        return corrupt();
+    document->m_ints = section<int64_t>(*file, header->intsOffset, header->numInts);
+    document->m_floats = section<float>(*file, header->floatsOffset, header->numFloats);
+    document->m_stringIds = stringIds;
+
+    // Atoms point into the mapped cache file like they point into the shark3d file after a parse
+    const char* chars = file->data() + header->charsOffset;
+    document->m_atoms.reserve(header->numAtoms);
+    for (const CachedAtom& atom : section<CachedAtom>(*file, header->atomsOffset, header->numAtoms)) {
+        if (!isInPool(atom.offset, atom.length, header->numChars))
+            return corrupt();
+        document->m_atoms.emplace_back(chars + atom.offset, atom.length);
+    }
+    document->rehash(std::bit_ceil(std::max<size_t>(64, 2 * document->m_atoms.size())));
+    document->m_source = std::move(file);
+    return document;
+}
+
+void SharkCache::save(const std::filesystem::path& cachePath, const PackageSource& source, const SharkDocument& document) {
+    std::vector<CachedSharkNode> nodes(document.m_nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const SharkNode& node = document.m_nodes[i];
+        nodes[i] = CachedSharkNode{static_cast<uint32_t>(node.type), node.nameId, node.offset, node.length};
+    }
+
+    std::vector<CachedAtom> atoms(document.m_atoms.size());
+    std::string chars;
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        atoms[i] = CachedAtom{static_cast<uint32_t>(chars.size()), static_cast<uint32_t>(document.m_atoms[i].size())};
+        chars += document.m_atoms[i];
+    }
+
+    SharkCacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.pakStamp = source.pakStamp;
+    header.sourceOffset = source.offset;
+    header.sourceSize = source.size;
+    header.numNodes = static_cast<uint32_t>(nodes.size());
+    header.numInts = static_cast<uint32_t>(document.m_ints.size());
+    header.numFloats = static_cast<uint32_t>(document.m_floats.size());
+    header.numStringIds = static_cast<uint32_t>(document.m_stringIds.size());
+    header.numAtoms = static_cast<uint32_t>(atoms.size());
+    header.numChars = static_cast<uint32_t>(chars.size());
+    header.nodesOffset = alignUp(sizeof(SharkCacheHeader));
+    header.intsOffset = alignUp(header.nodesOffset + nodes.size() * sizeof(CachedSharkNode));
+    header.floatsOffset = alignUp(header.intsOffset + document.m_ints.size() * sizeof(int64_t));
+    header.stringIdsOffset = alignUp(header.floatsOffset + document.m_floats.size() * sizeof(float));
+    header.atomsOffset = alignUp(header.stringIdsOffset + document.m_stringIds.size() * sizeof(uint32_t));
+    header.charsOffset = alignUp(header.atomsOffset + atoms.size() * sizeof(CachedAtom));
+    header.fileSize = header.charsOffset + chars.size();
+
+    // Several threads may cache the same file, each writes its own temporary file
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    std::error_code error;
+    std::filesystem::create_directories(cachePath.parent_path(), error);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            spdlog::error("Can't write shark cache {}", tempPath.string());
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeSection(out, header.nodesOffset, nodes.data(), nodes.size());
+        writeSection(out, header.intsOffset, document.m_ints.data(), document.m_ints.size());
+        writeSection(out, header.floatsOffset, document.m_floats.data(), document.m_floats.size());
+        writeSection(out, header.stringIdsOffset, document.m_stringIds.data(), document.m_stringIds.size());
+        writeSection(out, header.atomsOffset, atoms.data(), atoms.size());
+        writeSection(out, header.charsOffset, chars.data(), chars.size());
+    }
+
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+        spdlog::error("Can't replace shark cache {}: {}", cachePath.string(), error.message());
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+std::filesystem::path SharkCache::path(const std::filesystem::path& sharkPath, std::string_view subtree) {
+    std::filesystem::path result = cacheFolderPath / "shark" / sharkPath;
+    if (!subtree.empty()) {
+        std::string suffix = "." + std::string(subtree);
+        std::replace(suffix.begin(), suffix.end(), '/', '.');
+        result += suffix;
+    }
+    result += ".scache";
+    return result;
+}
+
+std::unique_ptr<SharkDocument> readCachedDocument(const std::filesystem::path& path, std::string_view subtree) {
+    // Loose files aren't cached, there's no pak entry to tell when they change
+    std::optional<PackageSource> source = PackageParser::instance().findSource(path);
+    std::filesystem::path cachePath = SharkCache::path(path, subtree);
+    if (source.has_value()) {
+        std::unique_ptr<SharkDocument> document = SharkCache::load(cachePath, *source);
+        if (document != nullptr)
+            return document;
+    }
+
+    SharkReader reader(path);
+    std::unique_ptr<SharkDocument> document = subtree.empty() ? reader.readAll() : reader.read(subtree);
+    if (document != nullptr && source.has_value())
+        SharkCache::save(cachePath, *source, *document);
+    return document;
+}
+
+} // namespace parser
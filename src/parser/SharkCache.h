@@ -0,0 +1,28 @@
+#pragma once
+
+#include "PackageParser.h"
+#include "SharkNode.h"
+
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+namespace parser {
+
+// Parsed shark3d documents saved with their pools as they are in memory (see SharkCache.cpp for the file layout),
+// so opening one maps the file instead of parsing. The value pools are used in place, only the nodes, which point to
+// their document, and the atom views are built on load. A cache is valid only for the .pak entry it was built from.
+class SharkCache {
+public:
+    // nullptr if the cache file is missing or stale
+    static std::unique_ptr<SharkDocument> load(const std::filesystem::path& cachePath, const PackageSource& source);
+    static void save(const std::filesystem::path& cachePath, const PackageSource& source, const SharkDocument& document);
+
+    // Cache file of `subtree` read from a file, the whole file if `subtree` is empty
+    static std::filesystem::path path(const std::filesystem::path& sharkPath, std::string_view subtree);
+};
+
+// SharkReader::read through the cache: files from a pak are parsed once, then loaded from their cache file
+std::unique_ptr<SharkDocument> readCachedDocument(const std::filesystem::path& path, std::string_view subtree);
+
+} // namespace parser
@@ -0,0 +1,273 @@
+#include "SharkDumper.h"
+#include "SharkReader.h"
+
+#include <spdlog/spdlog.h>
+
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace parser {
+
+namespace {
+
+// Collects the output in a large buffer and hands it to the stream in blocks
+class BufferedWriter {
+public:
+    explicit BufferedWriter(std::ostream& out)
+            : m_out(out) {
+        m_buffer.reserve(blockSize + 256);
+    }
+
+    ~BufferedWriter() { flush(); }
+
+    void write(std::string_view text) {
+        m_buffer.append(text);
+        if (m_buffer.size() >= blockSize)
+            flush();
+    }
+
+    void write(char c) {
+        m_buffer.push_back(c);
+        if (m_buffer.size() >= blockSize)
+            flush();
+    }
+
+    template <typename T>
+    void writeNumber(T value) {
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        write(std::string_view(digits, result.ptr - digits));
+    }
+
+    void indent(size_t depth) {
+        for (size_t i = 0; i < depth; ++i)
+            write(' ');
+    }
+
+    void flush() {
+        m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+
+private:
+    static constexpr size_t blockSize = 1 << 20;
+
+    std::ostream& m_out;
+    std::string m_buffer;
+};
+
+// Subs are objects, ArraySubs arrays of objects, Empty entries null
+class JsonDumper : public SharkVisitor {
+public:
+    explicit JsonDumper(BufferedWriter& writer)
+            : m_writer(writer) {}
+
+    void beginSub(std::string_view name) override {
+        beginEntry(name);
+        m_writer.write('{');
+        m_isFirst.push_back(true);
+    }
+
+    void endSub() override { endContainer('}'); }
+
+    void beginArray(std::string_view name, SharkNodeType, size_t) override {
+        beginEntry(name);
+        m_writer.write('[');
+        m_isFirst.push_back(true);
+    }
+
+    void endArray() override { endContainer(']'); }
+
+    void empty(std::string_view name) override {
+        beginEntry(name);
+        m_writer.write("null");
+    }
+
+    void value(std::string_view name, int64_t value) override {
+        beginEntry(name);
+        m_writer.writeNumber(value);
+    }
+
+    void value(std::string_view name, float value) override {
+        beginEntry(name);
+        if (std::isfinite(value))
+            m_writer.writeNumber(value);
+        else
+            m_writer.write("null");
+    }
+
+    void value(std::string_view name, std::string_view value) override {
+        beginEntry(name);
+        writeString(value);
+    }
+
+private:
+    // The root has no key and array elements come without names
+    void beginEntry(std::string_view name) {
+        if (m_isFirst.empty())
+            return;
+        if (!m_isFirst.back())
+            m_writer.write(',');
+        m_isFirst.back() = false;
+        m_writer.write('\n');
+        m_writer.indent(m_isFirst.size());
+        if (!name.empty()) {
+            writeString(name);
+            m_writer.write(": ");
+        }
+    }
+
+    void endContainer(char bracket) {
+        const bool isEmpty = m_isFirst.back();
+        m_isFirst.pop_back();
+        if (!isEmpty) {
+            m_writer.write('\n');
+            m_writer.indent(m_isFirst.size());
+        }
+        m_writer.write(bracket);
+        if (m_isFirst.empty())
+            m_writer.write('\n');
+    }
+
+    void writeString(std::string_view text) {
+        static const char hex[] = "0123456789abcdef";
+        m_writer.write('"');
+        size_t begin = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\')
+                continue;
+            m_writer.write(text.substr(begin, i - begin));
+            begin = i + 1;
+            if (c == '"' || c == '\\') {
+                m_writer.write('\\');
+                m_writer.write(static_cast<char>(c));
+            }
+            else {
+                const char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                m_writer.write(std::string_view(escape, sizeof(escape)));
+            }
+        }
+        m_writer.write(text.substr(begin));
+        m_writer.write('"');
+    }
+
+    BufferedWriter& m_writer;
+    std::vector<bool> m_isFirst; // per open container, whether no entry was written in it yet
+};
+
+// Names and scalars like print(), number and string arrays inline, the elements of an ArraySub as Subs of its name
+class TextDumper : public SharkVisitor {
+public:
+    explicit TextDumper(BufferedWriter& writer)
+            : m_writer(writer) {}
+
+    void beginSub(std::string_view name) override {
+        beginLine(name.empty() ? m_arrayNames.back() : name);
+        m_writer.write(": (s)\n");
+        ++m_depth;
+    }
+
+    void endSub() override { --m_depth; }
+
+    void beginArray(std::string_view name, SharkNodeType type, size_t count) override {
+        m_arrayNames.push_back(name);
+        m_isInline.push_back(type != SharkNodeType::ArraySub);
+        beginLine(name);
+        if (type == SharkNodeType::ArraySub) {
+            m_writer.write(": [");
+            m_writer.writeNumber(count);
+            m_writer.write("]\n");
+            ++m_depth;
+        }
+        else {
+            m_writer.write(" = [");
+            m_isFirstElement = true;
+        }
+    }
+
+    void endArray() override {
+        if (m_isInline.back())
+            m_writer.write("]\n");
+        else
+            --m_depth;
+        m_isInline.pop_back();
+        m_arrayNames.pop_back();
+    }
+
+    void empty(std::string_view name) override {
+        beginLine(name);
+        m_writer.write('\n');
+    }
+
+    void value(std::string_view name, int64_t value) override {
+        beginValue(name);
+        m_writer.writeNumber(value);
+        endValue();
+    }
+
+    void value(std::string_view name, float value) override {
+        beginValue(name);
+        m_writer.writeNumber(value);
+        endValue();
+    }
+
+    void value(std::string_view name, std::string_view value) override {
+        beginValue(name);
+        m_writer.write(value);
+        endValue();
+    }
+
+private:
+    void beginLine(std::string_view name) {
+        m_writer.indent(m_depth);
+        m_writer.write(name);
+    }
+
+    bool isInArray() const { return !m_isInline.empty() && m_isInline.back(); }
+
+    void beginValue(std::string_view name) {
+        if (!isInArray()) {
+            beginLine(name);
+            m_writer.write(" = ");
+        }
+        else if (!m_isFirstElement) {
+            m_writer.write(' ');
+        }
+        m_isFirstElement = false;
+    }
+
+    void endValue() {
+        if (!isInArray())
+            m_writer.write('\n');
+    }
+
+    BufferedWriter& m_writer;
+    size_t m_depth = 0;
+    std::vector<std::string_view> m_arrayNames;
+    std::vector<bool> m_isInline;
+    bool m_isFirstElement = false;
+};
+
+} // namespace
+
+bool dumpShark(const std::filesystem::path& path, SharkDumpFormat format, std::ostream& out) {
+    try {
+        SharkReader reader(path);
+        BufferedWriter writer(out);
+        if (format == SharkDumpFormat::Json) {
+            JsonDumper dumper(writer);
+            return reader.visit(dumper);
+        }
+        TextDumper dumper(writer);
+        return reader.visit(dumper);
+    }
+    catch (const std::exception& e) {
+        spdlog::error("Can't dump {}: {}", path.string(), e.what());
+        return false;
+    }
+}
+
+} // namespace parser
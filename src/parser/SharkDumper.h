@@ -0,0 +1,18 @@
+#pragma once
+
+#include <filesystem>
+#include <ostream>
+
+namespace parser {
+
+enum class SharkDumpFormat
+{
+    Json,
+    Text // one entry per line, indented like print()
+};
+
+// Writes a shark3d file to `out` straight from the binary through a buffer, no document is built.
+// False if the file can't be read or is corrupted, the output stops at the corrupted entry then.
+bool dumpShark(const std::filesystem::path& path, SharkDumpFormat format, std::ostream& out);
+
+} // namespace parser
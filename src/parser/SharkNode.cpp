@@ -1,28 +1,22 @@
 #include "SharkNode.h"
 
-#include <sstream>
+#include <algorithm>
 
 namespace parser {
 
-SharkNode* getNode(SharkNode* parent, const std::string& name) {
-    if (parent->type != SharkNodeType::Sub)
-        return nullptr;
-
-    SharkNodeSub* subNode = dynamic_cast<SharkNodeSub*>(parent);
-    for (SharkNode* node : subNode->value)
-        if (node->name == name)
-            return node;
-    return nullptr;
-}
+namespace {
 
-void print(SharkNode* node, std::ostream& out, const std::string& offset) {
-    out << offset << node->name;
+void printNode(const SharkNode* node, std::ostream& out, const std::string& offset, size_t depth) {
+    out << offset;
+    for (size_t i = 0; i < depth; ++i)
+        out << ' ';
+    out << node->name();
     if (node->type == SharkNodeType::Int)
-        out << " = " << dynamic_cast<SharkNodeValue<int64_t>*>(node)->value;
+        out << " = " << *node->value<int64_t>();
     if (node->type == SharkNodeType::Float)
-        out << " = " << dynamic_cast<SharkNodeValue<float>*>(node)->value;
+        out << " = " << *node->value<float>();
     if (node->type == SharkNodeType::String)
-        out << " = " << dynamic_cast<SharkNodeValue<std::string>*>(node)->value;
+        out << " = " << *node->value<std::string_view>();
     if (node->type == SharkNodeType::Sub)
         out << ": (s)";
 
@@ -34,21 +28,162 @@ void print(SharkNode* node, std::ostream& out, const std::string& offset) {
         out << " = string[" << node->count() << "]";
     if (node->type == SharkNodeType::ArraySub)
         out << ": [" << node->count() << "]";
-    out << std::endl;
+    out << '\n';
 
-    SharkNodeSub* subNode = dynamic_cast<SharkNodeSub*>(node);
-    if (subNode != nullptr) {
-        for (SharkNode* child : subNode->value) {
-            print(child, out, offset + " ");
-        }
+    if (node->type == SharkNodeType::Sub || node->type == SharkNodeType::ArraySub) {
+        for (uint32_t i = 0; i < node->length; ++i)
+            printNode(node->document->node(node->offset + i), out, offset, depth + 1);
     }
+}
+
+} // namespace
+
+std::string_view SharkNode::name() const {
+    return document->string(nameId);
+}
 
-    SharkNodeArray<SharkNode*>* subNodeArray = dynamic_cast<SharkNodeArray<SharkNode*>*>(node);
-    if (subNodeArray != nullptr) {
-        for (SharkNode* child : subNodeArray->value) {
-            print(child, out, offset + " ");
-        }
+const SharkNode* SharkNode::goSub(std::string_view path) const {
+    const SharkNode* node = this;
+    while (node != nullptr) {
+        size_t separator = path.find('/');
+        node = node->child(document->atom(path.substr(0, separator)));
+        if (separator == std::string_view::npos)
+            break;
+        path.remove_prefix(separator + 1);
     }
+    return node;
+}
+
+const SharkNode* SharkNode::goSub(const SharkPath& path) const {
+    if (!path.m_isResolved)
+        return nullptr;
+
+    const SharkNode* node = this;
+    for (size_t i = 0; i < path.m_atoms.size() && node != nullptr; ++i)
+        node = node->child(path.m_atoms[i]);
+    return node;
+}
+
+const SharkNode* SharkNode::child(uint32_t atom) const {
+    if (type != SharkNodeType::Sub || atom == SharkDocument::noAtom)
+        return nullptr;
+
+    const SharkNode* children = document->node(offset);
+    for (uint32_t i = 0; i < length; ++i) {
+        if (children[i].nameId == atom)
+            return &children[i];
+    }
+    return nullptr;
+}
+
+const SharkNode* SharkNode::at(int index) const {
+    if (type == SharkNodeType::Sub)
+        return this;
+    if (type == SharkNodeType::ArraySub && index >= 0 && static_cast<uint32_t>(index) < length)
+        return document->node(offset + index);
+    return nullptr;
+}
+
+size_t SharkNode::count() const {
+    switch (type) {
+    case SharkNodeType::Sub:
+        return 1;
+    case SharkNodeType::ArrayInt:
+    case SharkNodeType::ArrayFloat:
+    case SharkNodeType::ArrayString:
+    case SharkNodeType::ArraySub:
+        return length;
+    default:
+        return 0;
+    }
+}
+
+const SharkNode* SharkDocument::root() const {
+    return m_nodes.empty() ? nullptr : &m_nodes.front();
+}
+
+uint32_t SharkDocument::atom(std::string_view string) const {
+    return m_atomTable.empty() ? noAtom : m_atomTable[findSlot(string)];
+}
+
+std::string_view SharkDocument::string(uint32_t atom) const {
+    return m_atoms[atom];
+}
+
+size_t SharkDocument::numberOfAtoms() const {
+    return m_atoms.size();
+}
+
+uint32_t SharkDocument::intern(std::string_view string) {
+    if (2 * (m_atoms.size() + 1) > m_atomTable.size())
+        rehash(std::max<size_t>(64, 2 * m_atomTable.size()));
+
+    const size_t slot = findSlot(string);
+    if (m_atomTable[slot] == noAtom) {
+        m_atomTable[slot] = static_cast<uint32_t>(m_atoms.size());
+        m_atoms.push_back(string);
+    }
+    return m_atomTable[slot];
+}
+
+size_t SharkDocument::findSlot(std::string_view string) const {
+    const size_t mask = m_atomTable.size() - 1;
+    size_t slot = std::hash<std::string_view>{}(string) & mask;
+    while (m_atomTable[slot] != noAtom && m_atoms[m_atomTable[slot]] != string)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+void SharkDocument::bindPools() {
+    m_ints = m_parsedInts;
+    m_floats = m_parsedFloats;
+    m_stringIds = m_parsedStringIds;
+}
+
+void SharkDocument::rehash(size_t size) {
+    m_atomTable.assign(size, noAtom);
+    for (uint32_t atom = 0; atom < m_atoms.size(); ++atom)
+        m_atomTable[findSlot(m_atoms[atom])] = atom;
+}
+
+const SharkNode* SharkDocument::node(uint32_t index) const {
+    return &m_nodes[index];
+}
+
+size_t SharkDocument::numberOfNodes() const {
+    return m_nodes.size();
+}
+
+size_t SharkDocument::memorySize() const {
+    // The strings themselves stay in the mapped file, so do the values of a document loaded from the cache
+    return m_nodes.capacity() * sizeof(SharkNode) + m_parsedInts.capacity() * sizeof(int64_t) +
+           m_parsedFloats.capacity() * sizeof(float) + m_parsedStringIds.capacity() * sizeof(uint32_t) +
+           m_atoms.capacity() * sizeof(std::string_view) + m_atomTable.capacity() * sizeof(uint32_t);
+}
+
+SharkPath::SharkPath(const SharkDocument& document, std::string_view path)
+        : m_isResolved(true) {
+    while (true) {
+        size_t separator = path.find('/');
+        uint32_t atom = document.atom(path.substr(0, separator));
+        m_isResolved = m_isResolved && atom != SharkDocument::noAtom;
+        m_atoms.push_back(atom);
+        if (separator == std::string_view::npos)
+            break;
+        path.remove_prefix(separator + 1);
+    }
+}
+
+bool SharkPath::isResolved() const {
+    return m_isResolved;
+}
+
+const SharkNode* getNode(const SharkNode* parent, std::string_view name) {
+    return parent->child(parent->document->atom(name));
+}
+
+void print(const SharkNode* node, std::ostream& out, const std::string& offset) {
+    printNode(node, out, offset, 0);
 }
 
-} // namespace parser
\ No newline at end of file
+} // namespace parser
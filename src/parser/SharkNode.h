@@ -2,8 +2,13 @@
 
 #include "Utils.h"
 
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <ostream>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace parser {
@@ -21,134 +26,186 @@ enum SharkNodeType
     ArraySub
 };
 
-struct SharkNode;
-SharkNode* getNode(SharkNode* parent, const std::string& name);
-void print(SharkNode* node, std::ostream& out, const std::string& offset);
+class BinReader;
+class SharkDocument;
+class SharkPath;
 
+// Tagged node of a SharkDocument. Values aren't stored in the node: `offset` and `length` select them in the pool of
+// the node type (ints, floats or string ids), children of Sub and elements of ArraySub are consecutive nodes.
 struct SharkNode {
-    SharkNodeType type;
-    std::string name;
-
-    SharkNode(std::string name)
-            : type(SharkNodeType::Empty)
-            , name(std::move(name)) {}
-
-    virtual ~SharkNode() = default;
-
-    SharkNode* goSub(const std::string& path) {
-        std::string next = Utils::splitString(path, '/')[0];
-        SharkNode* nextNode = getNode(this, next);
-        if (nextNode == nullptr || next == path)
-            return nextNode;
-        std::string leftPath = std::string(path.begin() + path.find('/') + 1, path.end());
-        return nextNode->goSub(leftPath);
-    }
-
-    virtual SharkNode* at(int) { return nullptr; };
-
-    virtual size_t count() { return 0; };
+    SharkNodeType type = SharkNodeType::Empty;
+    uint32_t nameId = 0; // atom of the name, see SharkDocument::atom
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    const SharkDocument* document = nullptr;
+
+    std::string_view name() const;
+
+    // Path of child names separated by '/'. Use a SharkPath for paths queried on many nodes.
+    const SharkNode* goSub(std::string_view path) const;
+    const SharkNode* goSub(const SharkPath& path) const;
+    const SharkNode* child(uint32_t atom) const;
+
+    // A Sub is an array of itself, an ArraySub of its elements
+    const SharkNode* at(int index) const;
+    size_t count() const;
+
+    template <typename T>
+    std::optional<T> value() const;
+    template <typename T>
+    std::optional<std::vector<T>> array() const;
+    // Ints or floats of the node in the document pool, one for a single value, empty if the type differs
+    template <typename T>
+    std::span<const T> values() const;
 };
 
-template <typename T>
-struct SharkNodeValue : public SharkNode {
-    T value;
-
-    SharkNodeValue(T value, std::string name)
-            : value(std::move(value))
-            , SharkNode(name) {
-        if constexpr (std::is_same_v<T, int64_t>)
-            type = SharkNodeType::Int;
-        else if constexpr (std::is_same_v<T, float>)
-            type = SharkNodeType::Float;
-        else if constexpr (std::is_same_v<T, std::string>)
-            type = SharkNodeType::String;
-        else
-            static_assert(std::false_type::value, "unsupported type");
-    }
-
-    virtual ~SharkNodeValue() = default;
+// Nodes and values of one shark3d file. Everything lives in a handful of typed pools,
+// so the whole tree is freed at once with the document. Must not be moved once nodes point to it.
+// Strings aren't copied: atoms are views into the mapped file, which the document keeps open. The value pools of a
+// document loaded from the cache are views into the mapped cache file as well.
+class SharkDocument {
+public:
+    SharkDocument() = default;
+    SharkDocument(const SharkDocument&) = delete;
+    SharkDocument& operator=(const SharkDocument&) = delete;
+
+    const SharkNode* root() const;
+
+    // Every distinct string of the file is interned once, names and string values are atoms
+    static constexpr uint32_t noAtom = ~uint32_t(0);
+    uint32_t atom(std::string_view string) const; // noAtom if the string doesn't occur in the document
+    std::string_view string(uint32_t atom) const;
+    size_t numberOfAtoms() const;
+
+    const SharkNode* node(uint32_t index) const;
+    size_t numberOfNodes() const;
+
+    // Bytes held by the pools
+    size_t memorySize() const;
+
+private:
+    friend class SharkCache;
+    friend class SharkReader;
+    friend struct SharkNode;
+
+    uint32_t intern(std::string_view string);
+    // Points the value pools at the vectors SharkReader appended to, once it is done with the document
+    void bindPools();
+    size_t findSlot(std::string_view string) const;
+    void rehash(size_t size);
+
+    std::vector<SharkNode> m_nodes; // m_nodes[0] is the root
+    // Value pools the nodes select from, either the vectors below or sections of the mapped cache file
+    std::span<const int64_t> m_ints;
+    std::span<const float> m_floats;
+    std::span<const uint32_t> m_stringIds; // atoms of String and ArrayString values
+    std::vector<int64_t> m_parsedInts;
+    std::vector<float> m_parsedFloats;
+    std::vector<uint32_t> m_parsedStringIds;
+    std::vector<std::string_view> m_atoms;
+    std::vector<uint32_t> m_atomTable; // open addressing over m_atoms, a power of two of slots, noAtom marks free ones
+    std::shared_ptr<const BinReader> m_source; // the file the atoms point into
 };
 
-template <>
-struct SharkNodeValue<std::vector<SharkNode*>> : public SharkNode {
-    std::vector<SharkNode*> value;
-
-    SharkNodeValue(std::vector<SharkNode*> value, std::string name)
-            : value(std::move(value))
-            , SharkNode(name) {
-        type = SharkNodeType::Sub;
-    }
+// Path resolved once into the atoms of a document, for queries repeated on many nodes of it
+class SharkPath {
+public:
+    SharkPath() = default;
+    SharkPath(const SharkDocument& document, std::string_view path);
 
-    size_t count() override { return 1; };
+    // False if a name of the path doesn't occur in the document, no node can match then
+    bool isResolved() const;
 
-    SharkNode* at(int) override { return dynamic_cast<SharkNode*>(this); }
+private:
+    friend struct SharkNode;
 
-    virtual ~SharkNodeValue() {
-        for (auto* node : value) {
-            delete node;
-        }
-    }
+    std::vector<uint32_t> m_atoms;
+    bool m_isResolved = false;
 };
 
-using SharkNodeSub = SharkNodeValue<std::vector<SharkNode*>>;
+const SharkNode* getNode(const SharkNode* parent, std::string_view name);
+void print(const SharkNode* node, std::ostream& out, const std::string& offset);
 
 template <typename T>
-struct SharkNodeArray : public SharkNode {
-    std::vector<T> value;
-
-    SharkNodeArray(std::vector<T> value, std::string name)
-            : value(std::move(value))
-            , SharkNode(name) {
-        if constexpr (std::is_same_v<T, int64_t>)
-            type = SharkNodeType::ArrayInt;
-        else if constexpr (std::is_same_v<T, float>)
-            type = SharkNodeType::ArrayFloat;
-        else if constexpr (std::is_same_v<T, std::string>)
-            type = SharkNodeType::ArrayString;
-        else
-            static_assert(std::false_type::value, "unsupported type");
-    }
-
-    size_t count() override { return value.size(); };
-
-    virtual ~SharkNodeArray() = default;
-};
-
-template <>
-struct SharkNodeArray<SharkNode*> : public SharkNode {
-    std::vector<SharkNode*> value;
+std::optional<T> SharkNode::value() const {
+    if constexpr (std::is_same_v<T, int64_t>)
+        return type == SharkNodeType::Int ? std::optional(document->m_ints[offset]) : std::nullopt;
+    else if constexpr (std::is_same_v<T, float>)
+        return type == SharkNodeType::Float ? std::optional(document->m_floats[offset]) : std::nullopt;
+    else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+        return type == SharkNodeType::String ? std::optional(T(document->string(document->m_stringIds[offset]))) : std::nullopt;
+    else
+        static_assert(!sizeof(T), "unsupported type");
+}
 
-    SharkNodeArray(std::vector<SharkNode*> value, std::string name)
-            : value(std::move(value))
-            , SharkNode(name) {
-        type = SharkNodeType::ArraySub;
+template <typename T>
+std::optional<std::vector<T>> SharkNode::array() const {
+    if constexpr (std::is_same_v<T, int64_t>) {
+        if (type != SharkNodeType::ArrayInt)
+            return std::nullopt;
+        std::span<const T> result = values<T>();
+        return std::vector<T>(result.begin(), result.end());
     }
-
-    size_t count() override { return value.size(); };
-
-    SharkNode* at(int index) override { return value.at(index); }
-
-    virtual ~SharkNodeArray() {
-        for (auto* node : value) {
-            delete node;
-        }
+    else if constexpr (std::is_same_v<T, float>) {
+        if (type != SharkNodeType::ArrayFloat)
+            return std::nullopt;
+        std::span<const T> result = values<T>();
+        return std::vector<T>(result.begin(), result.end());
     }
-};
+    else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+        if (type != SharkNodeType::ArrayString)
+            return std::nullopt;
+        std::vector<T> result;
+        result.reserve(length);
+        for (uint32_t i = 0; i < length; ++i)
+            result.emplace_back(document->string(document->m_stringIds[offset + i]));
+        return result;
+    }
+    else {
+        static_assert(!sizeof(T), "unsupported type");
+    }
+}
 
 template <typename T>
-std::optional<T> getEntryValue(SharkNode* node, const std::string& name) {
-    SharkNode* cur = node->goSub(name);
+std::span<const T> SharkNode::values() const {
+    if constexpr (std::is_same_v<T, int64_t>) {
+        if (type != SharkNodeType::Int && type != SharkNodeType::ArrayInt)
+            return {};
+        return std::span<const T>(document->m_ints.data() + offset, length);
+    }
+    else if constexpr (std::is_same_v<T, float>) {
+        if (type != SharkNodeType::Float && type != SharkNodeType::ArrayFloat)
+            return {};
+        return std::span<const T>(document->m_floats.data() + offset, length);
+    }
+    else {
+        static_assert(!sizeof(T), "unsupported type");
+    }
+}
+
+template <typename T, typename Path>
+std::optional<T> getEntryValue(const SharkNode* node, const Path& path) {
+    const SharkNode* cur = node->goSub(path);
     if (cur == nullptr)
         return std::nullopt;
-    return dynamic_cast<SharkNodeValue<T>*>(cur)->value;
+    return cur->value<T>();
 }
 
-template <typename T>
-std::optional<std::vector<T>> getEntryArray(SharkNode* node, const std::string& name) {
-    SharkNode* cur = node->goSub(name);
+template <typename T, typename Path>
+std::optional<std::vector<T>> getEntryArray(const SharkNode* node, const Path& path) {
+    const SharkNode* cur = node->goSub(path);
     if (cur == nullptr)
         return std::nullopt;
-    return dynamic_cast<SharkNodeArray<T>*>(cur)->value;
+    return cur->array<T>();
+}
+
+// Like getEntryArray without copying, empty if there's no such entry
+template <typename T, typename Path>
+std::span<const T> getEntryValues(const SharkNode* node, const Path& path) {
+    const SharkNode* cur = node->goSub(path);
+    if (cur == nullptr)
+        return {};
+    return cur->values<T>();
 }
 
-} // namespace parser
\ No newline at end of file
+} // namespace parser
@@ -1,60 +1,62 @@
 #include "SharkParser.h"
-#include "BinReader.h"
-#include "PackageParser.h"
+#include "SharkBatch.h"
+#include "SharkCache.h"
+#include "SharkQuery.h"
+#include "SharkReader.h"
 #include "Utils.h"
 
-#include <spdlog/spdlog.h>
+namespace parser {
 
-#include <cassert>
-#include <fstream>
+namespace {
+
+// Loadtree objects in a children list, in those of the capsules among them and so on. The elements of the list carry
+// its name, so the top-level entries match like the nested ones.
+const SharkQuery& sirQuery() {
+    static const SharkQuery query = [] {
+        SharkQuery sirs;
+        sirs.add("**/children[type=mod_engobj_funcom.loadtree]/param/tree");
+        return sirs;
+    }();
+    return query;
+}
 
-namespace parser {
+const SharkQuery& bprQuery() {
+    static const SharkQuery query = [] {
+        SharkQuery bprs;
+        bprs.add("actor_param/child_param/children/*[type=mod_engobj_funcom.locationinit]/param/bpr_files");
+        return bprs;
+    }();
+    return query;
+}
 
-std::vector<std::string> getSir(SharkNode* children) {
-    if (children == nullptr)
-        return {};
+} // namespace
 
+std::vector<std::string> getSir(const SharkNode* children) {
     std::vector<std::string> sirs;
-    for (int i = 0; i < children->count(); i++) {
-        SharkNode* child = children->at(i);
-        auto type = getEntryValue<std::string>(child, "type");
-        if (type.has_value() && *type == "mod_engobj_funcom.loadtree") {
-            auto name = getEntryValue<std::string>(child, "param/tree");
-            if (name.has_value())
-                sirs.emplace_back(*name);
-        }
-
-        if (type.has_value() && *type == "mod_core.capsule") {
-            std::vector<std::string> newSirs = getSir(child->goSub("param/child_param/children"));
-            sirs.reserve(sirs.size() + newSirs.size());
-            std::move(std::begin(newSirs), std::end(newSirs), std::back_inserter(sirs));
-        }
-    }
-
+    sirQuery().run(children, [&](size_t, const SharkNode* tree) {
+        auto name = tree->value<std::string>();
+        if (name.has_value())
+            sirs.emplace_back(std::move(*name));
+    });
     return sirs;
 }
 
-std::vector<std::string> getBpr(SharkNode* root) {
-    SharkNode* node = root->goSub("actor_param/child_param/children");
-    for (int i = 0; node != nullptr && i < node->count(); i++) {
-        auto type = getEntryValue<std::string>(node->at(i), "type");
-        if (type.has_value() && *type == "mod_engobj_funcom.locationinit")
-            return *getEntryArray<std::string>(node->at(i), "param/bpr_files");
-    }
-    return {};
+std::vector<std::string> getBpr(const SharkNode* root) {
+    std::vector<std::string> bprs;
+    bool isFound = false;
+    bprQuery().run(root, [&](size_t, const SharkNode* files) {
+        // Only the first locationinit with bpr files counts
+        if (!isFound)
+            bprs = files->array<std::string>().value_or(std::vector<std::string>{});
+        isFound = true;
+    });
+    return bprs;
 }
 
-SharkParser::SharkParser(const std::filesystem::path& path) {
-    PackageParser::instance().tryExtract(path);
-    BinReaderMmap binReader(path);
-    if (binReader.readStringLine() != magic || binReader.readStringLine() != "2x4")
-        throw std::exception("shark3d binary magic wrong");
-    m_root.reset(new SharkNodeValue(readSub(binReader), "root"));
-}
-
-SceneIndex SharkParser::parseScene(const std::string& bundleName) {
-    std::vector<std::string> sirs = getSir(m_root->goSub("actor_param/child_param/children"));
-    std::vector<std::string> bprs = getBpr(m_root.get());
+SceneIndex parseSceneIndex(const std::filesystem::path& cdrPath, const std::string& bundleName, ThreadPool* pool) {
+    // Only the SIR names are needed, the rest of the location is skipped
+    std::unique_ptr<SharkDocument> children = readCachedDocument(cdrPath, "actor_param/child_param/children");
+    std::vector<std::string> sirs = getSir(children ? children->root() : nullptr);
 
     SceneIndex sceneIndex;
     sceneIndex.bundleName = bundleName;
@@ -64,82 +66,35 @@ SceneIndex SharkParser::parseScene(const std::string& bundleName) {
         sceneIndex.sirs.emplace_back(entry);
     }
 
+    if (pool != nullptr) {
+        std::vector<SirEntry*> entries;
+        for (SirEntry& entry : sceneIndex.sirs)
+            entries.push_back(&entry);
+        parseSirDocuments(entries, *pool);
+    }
     return sceneIndex;
 }
 
-SharkNode* SharkParser::getRoot() const {
-    return m_root.get();
+void parseSirDocuments(const std::vector<SirEntry*>& sirs, ThreadPool& pool) {
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(sirs.size());
+    for (const SirEntry* sir : sirs)
+        paths.emplace_back(sir->sirPath);
+
+    SharkBatch batch = parseSharkFiles(paths, pool, "data/root");
+    for (size_t i = 0; i < sirs.size(); ++i)
+        sirs[i]->hierarchy = std::move(batch.documents[i]);
 }
 
-std::string SharkParser::indexString(BinReader& binReader) {
-    int num = static_cast<int>(binReader.readSharkNum());
-    int index = m_stringCount - num;
-    if (num == 0)
-        m_stringCount++;
-    if (m_stringTable.find(index) != m_stringTable.end())
-        return m_stringTable[index];
-    std::string result = binReader.readStringLine();
-    m_stringTable.emplace(index, result);
-    return result;
+SharkParser::SharkParser(const std::filesystem::path& path)
+        : m_document(SharkReader(path).readAll()) {}
+
+const SharkNode* SharkParser::getRoot() const {
+    return m_document->root();
 }
 
-std::vector<SharkNode*> SharkParser::readSub(BinReader& binReader) {
-    int num = static_cast<int>(binReader.readSharkNum());
-
-    std::vector<SharkNode*> nodes(num);
-    for (int i = 0; i < num; i++) {
-        std::string name = indexString(binReader);
-        int attachCode = binReader.readByte();
-        switch (attachCode) {
-        case 0:
-            nodes[i] = new SharkNode(name);
-            break;
-        case 1:
-            nodes[i] = new SharkNodeValue(binReader.readSharkNum(), name);
-            break;
-        case 2: {
-            std::vector<int64_t> table(binReader.readSharkNum());
-            for (int e = 0; e < table.size(); e++)
-                table[e] = binReader.readSharkNum();
-            nodes[i] = new SharkNodeArray(table, name);
-            break;
-        }
-        case 4:
-            nodes[i] = new SharkNodeValue(binReader.readEndianFloat(), name);
-            break;
-        case 8: {
-            std::vector<float> table(binReader.readSharkNum());
-            for (int e = 0; e < table.size(); e++)
-                table[e] = binReader.readEndianFloat();
-            nodes[i] = new SharkNodeArray(table, name);
-            break;
-        }
-        case 0x10:
-            nodes[i] = new SharkNodeValue(indexString(binReader), name);
-            break;
-        case 0x20: {
-            std::vector<std::string> table(binReader.readSharkNum());
-            for (int e = 0; e < table.size(); e++)
-                table[e] = indexString(binReader);
-            nodes[i] = new SharkNodeArray(table, name);
-            break;
-        }
-        case 0x40:
-            nodes[i] = new SharkNodeValue(readSub(binReader), name);
-            break;
-        case 0x80: {
-            std::vector<SharkNode*> table(binReader.readSharkNum());
-            for (int e = 0; e < table.size(); e++)
-                table[e] = new SharkNodeValue(readSub(binReader), name);
-            nodes[i] = new SharkNodeArray(table, name);
-            break;
-        }
-        default:
-            spdlog::error("Unrecognized code in shark3d binary!");
-            return {};
-        }
-    }
-    return nodes;
+const SharkDocument& SharkParser::document() const {
+    return *m_document;
 }
 
-} // namespace parser
\ No newline at end of file
+} // namespace parser
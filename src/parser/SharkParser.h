@@ -4,33 +4,35 @@
 #include "SharkNode.h"
 
 #include <filesystem>
+#include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 namespace parser {
 
-class BinReader;
+// SIR paths of the loadtree entries among `children` and in the children lists below them, those of capsules included
+std::vector<std::string> getSir(const SharkNode* children);
+// bpr files of the (first) locationinit entry of a location
+std::vector<std::string> getBpr(const SharkNode* root);
 
+class ThreadPool;
+
+// SIRs referenced by a location's .cdr, read without building the rest of its tree. With a `pool` the hierarchies of
+// the SIRs are parsed on it too, see parseSirDocuments.
+SceneIndex parseSceneIndex(const std::filesystem::path& cdrPath, const std::string& bundleName, ThreadPool* pool = nullptr);
+// Parses the data/root hierarchies of the SIRs as one batch on `pool` into SirEntry::hierarchy
+void parseSirDocuments(const std::vector<SirEntry*>& sirs, ThreadPool& pool);
+
+// Whole shark3d file, see SharkReader to read only a part of it
 class SharkParser {
 public:
     SharkParser(const std::filesystem::path& path);
 
-    SceneIndex parseScene(const std::string& bundleName); // TODO: Move it outside SharkParser
-
-    SharkNode* getRoot() const;
+    const SharkNode* getRoot() const;
+    const SharkDocument& document() const;
 
 private:
-    std::string indexString(BinReader& binReader);
-    std::vector<SharkNode*> readSub(BinReader& binReader);
-
-    int m_stringCount = 0;
-
-    std::unique_ptr<SharkNode> m_root;
-
-    std::unordered_map<int, std::string> m_stringTable;
-
-    const std::string magic = "shark3d_snake_binary";
+    std::unique_ptr<SharkDocument> m_document;
 };
 
 } // namespace parser
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "SharkQuery.h"
+
+#include <algorithm>
+
+namespace parser {
+
+// Steps of one document: names resolved into its atoms, predicate paths into SharkPaths
+class SharkQuery::Matcher {
+public:
+    Matcher(const SharkQuery& query, const SharkDocument& document,
+            const std::function<void(size_t selector, const SharkNode* node)>& onMatch)
+            : m_onMatch(onMatch) {
+        for (const auto& steps : query.m_selectors) {
+            std::vector<BoundStep>& boundSteps = m_selectors.emplace_back();
+            for (const Step& step : steps) {
+                BoundStep boundStep{step.kind, step.kind == StepKind::Name ? document.atom(step.name) : SharkDocument::noAtom, {}};
+                for (const Predicate& predicate : step.predicates)
+                    boundStep.predicates.push_back(BoundPredicate{SharkPath(document, predicate.path), predicate.value});
+                boundSteps.push_back(std::move(boundStep));
+            }
+        }
+    }
+
+    void run(const SharkNode* root) {
+        std::vector<State> states;
+        for (uint32_t selector = 0; selector < m_selectors.size(); ++selector)
+            addState(states, State{selector, 0});
+        visit(root, states);
+    }
+
+private:
+    struct BoundPredicate {
+        SharkPath path;
+        std::string_view value;
+    };
+
+    struct BoundStep {
+        StepKind kind;
+        uint32_t atom;
+        std::vector<BoundPredicate> predicates;
+    };
+
+    // Step of a selector to match against the children of the current node
+    struct State {
+        uint32_t selector;
+        uint32_t step;
+
+        bool operator==(const State&) const = default;
+    };
+
+    void addState(std::vector<State>& states, State state) const {
+        while (std::find(states.begin(), states.end(), state) == states.end()) {
+            states.push_back(state);
+            // ** stays active for deeper levels and lets the next step match at this one
+            if (m_selectors[state.selector][state.step].kind != StepKind::AnyDepth)
+                break;
+            ++state.step;
+        }
+    }
+
+    bool matches(const BoundStep& step, const SharkNode* node) const {
+        if (step.kind == StepKind::Name && node->nameId != step.atom)
+            return false;
+        for (const BoundPredicate& predicate : step.predicates) {
+            const SharkNode* entry = node->goSub(predicate.path);
+            if (entry == nullptr || entry->value<std::string_view>() != predicate.value)
+                return false;
+        }
+        return true;
+    }
+
+    // Depth-first over the nodes below `root` with an explicit stack, the states of the children of a node at
+    // depth d are `rootStates` for the root and m_levels[d - 1].states below it
+    void visit(const SharkNode* root, const std::vector<State>& rootStates) {
+        std::vector<OpenNode> openNodes;
+        if (root->type == SharkNodeType::Sub || root->type == SharkNodeType::ArraySub)
+            openNodes.push_back(OpenNode{root, 0});
+        while (!openNodes.empty()) {
+            OpenNode& open = openNodes.back();
+            if (open.next == open.node->length) {
+                openNodes.pop_back();
+                continue;
+            }
+
+            const size_t depth = openNodes.size() - 1;
+            if (m_levels.size() <= depth)
+                m_levels.resize(depth + 1);
+            const std::vector<State>& states = depth == 0 ? rootStates : m_levels[depth - 1].states;
+            const SharkNode* child = open.node->document->node(open.node->offset + open.next++);
+            std::vector<State>& next = m_levels[depth].states;
+            std::vector<uint32_t>& matched = m_levels[depth].matched;
+            next.clear();
+            matched.clear();
+            for (const State& state : states) {
+                const std::vector<BoundStep>& steps = m_selectors[state.selector];
+                const BoundStep& step = steps[state.step];
+                if (step.kind == StepKind::AnyDepth)
+                    addState(next, state);
+                else if (!matches(step, child))
+                    continue;
+                else if (state.step + 1 == steps.size())
+                    matched.push_back(state.selector);
+                else
+                    addState(next, State{state.selector, state.step + 1});
+            }
+
+            std::sort(matched.begin(), matched.end());
+            matched.erase(std::unique(matched.begin(), matched.end()), matched.end());
+            for (uint32_t selector : matched)
+                m_onMatch(selector, child);
+            if (!next.empty() && (child->type == SharkNodeType::Sub || child->type == SharkNodeType::ArraySub))
+                openNodes.push_back(OpenNode{child, 0});
+        }
+    }
+
+    struct OpenNode {
+        const SharkNode* node;
+        uint32_t next;
+    };
+
+    struct Level {
+        std::vector<State> states;
+        std::vector<uint32_t> matched;
+    };
+
+    const std::function<void(size_t selector, const SharkNode* node)>& m_onMatch;
+    std::vector<std::vector<BoundStep>> m_selectors;
+    std::vector<Level> m_levels; // reused by the nodes of a depth
+};
+
+size_t SharkQuery::add(std::string_view selector) {
+    std::vector<Step> steps;
+    while (!selector.empty()) {
+        Step& step = steps.emplace_back();
+        const size_t nameEnd = std::min(selector.find('['), selector.find('/'));
+        std::string_view name = selector.substr(0, nameEnd);
+        selector.remove_prefix(name.size());
+        if (name == "**")
+            step.kind = StepKind::AnyDepth;
+        else if (name == "*")
+            step.kind = StepKind::Any;
+        else if (!name.empty() && name.find('*') == std::string_view::npos)
+            step = Step{StepKind::Name, std::string(name), {}};
+        else
+            throw std::exception("malformed shark3d query step");
+
+        while (!selector.empty() && selector.front() == '[') {
+            const size_t equals = selector.find('=');
+            const size_t end = selector.find(']');
+            if (step.kind == StepKind::AnyDepth || equals == std::string_view::npos || end == std::string_view::npos ||
+                equals > end)
+                throw std::exception("malformed shark3d query predicate");
+            step.predicates.push_back(Predicate{std::string(selector.substr(1, equals - 1)),
+                                                std::string(selector.substr(equals + 1, end - equals - 1))});
+            selector.remove_prefix(end + 1);
+        }
+
+        if (!selector.empty()) {
+            if (selector.front() != '/' || selector.size() == 1)
+                throw std::exception("malformed shark3d query selector");
+            selector.remove_prefix(1);
+        }
+    }
+
+    if (steps.empty() || steps.back().kind == StepKind::AnyDepth)
+        throw std::exception("shark3d query selector has to end with a name or *");
+    m_selectors.push_back(std::move(steps));
+    return m_selectors.size() - 1;
+}
+
+size_t SharkQuery::size() const {
+    return m_selectors.size();
+}
+
+void SharkQuery::run(const SharkNode* root, const std::function<void(size_t selector, const SharkNode* node)>& onMatch) const {
+    if (root == nullptr || m_selectors.empty())
+        return;
+    Matcher(*this, *root->document, onMatch).run(root);
+}
+
+std::vector<std::vector<const SharkNode*>> SharkQuery::run(const SharkNode* root) const {
+    std::vector<std::vector<const SharkNode*>> matches(m_selectors.size());
+    run(root, [&](size_t selector, const SharkNode* node) { matches[selector].push_back(node); });
+    return matches;
+}
+
+} // namespace parser
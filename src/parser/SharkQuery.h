@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SharkNode.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace parser {
+
+// Selectors over the children of a SharkNode, compiled once and matched together in a single traversal.
+// Steps are separated by '/':
+//   name    a child with this name. The elements of an ArraySub are its children and carry its name.
+//   *       any child
+//   **      any number of levels, none included. A selector can't end with it.
+//   [k=v]   after name or *: the String entry at path k of the child equals v, can be repeated
+// "**/children/*[type=mod_engobj_funcom.loadtree]/param/tree" finds the SIRs of a location.
+class SharkQuery {
+public:
+    // Index of the selector in the matches, throws if the selector is malformed
+    size_t add(std::string_view selector);
+    size_t size() const;
+
+    // Every node matching a selector, in document order. A node matched by several selectors is reported once for each.
+    void run(const SharkNode* root, const std::function<void(size_t selector, const SharkNode* node)>& onMatch) const;
+    // Matches per selector
+    std::vector<std::vector<const SharkNode*>> run(const SharkNode* root) const;
+
+private:
+    enum StepKind
+    {
+        Name,
+        Any,
+        AnyDepth
+    };
+
+    struct Predicate {
+        std::string path;
+        std::string value;
+    };
+
+    struct Step {
+        StepKind kind = StepKind::Any;
+        std::string name;
+        std::vector<Predicate> predicates;
+    };
+
+    class Matcher;
+
+    std::vector<std::vector<Step>> m_selectors;
+};
+
+} // namespace parser
@@ -0,0 +1,415 @@
+#include "SharkReader.h"
+#include "BinReader.h"
+#include "PackageParser.h"
+
+#include <spdlog/spdlog.h>
+
+namespace parser {
+
+namespace {
+
+const std::string magic = "shark3d_snake_binary";
+
+std::shared_ptr<BinReaderMmap> extractAndOpen(const std::filesystem::path& path) {
+    PackageParser::instance().tryExtract(path);
+    return std::make_shared<BinReaderMmap>(path);
+}
+
+} // namespace
+
+SharkReader::SharkReader(const std::filesystem::path& path)
+        : SharkReader(extractAndOpen(path)) {}
+
+SharkReader::SharkReader(std::shared_ptr<BinReaderMmap> file)
+        : m_binReader(std::move(file)) {
+    if (!m_binReader->isOpen() || m_binReader->size() < magic.size())
+        throw std::exception("can't open shark3d binary");
+    if (m_binReader->readStringLine() != magic || m_binReader->readStringLine() != "2x4")
+        throw std::exception("shark3d binary magic wrong");
+    m_rootPosition = m_binReader->getPosition();
+}
+
+SharkReader::~SharkReader() = default;
+
+std::unique_ptr<SharkDocument> SharkReader::readAll() {
+    auto document = std::make_unique<SharkDocument>();
+    rewind(document.get());
+    document->m_source = m_binReader;
+    document->m_nodes.push_back(SharkNode{SharkNodeType::Sub, document->intern("root"), 0, 0, document.get()});
+    readSubtree(0);
+    document->bindPools();
+    m_document = nullptr;
+    return document;
+}
+
+std::unique_ptr<SharkDocument> SharkReader::read(std::string_view path) {
+    rewind(nullptr);
+    while (true) {
+        const size_t separator = path.find('/');
+        const std::string_view name = path.substr(0, separator);
+        const uint32_t num = static_cast<uint32_t>(m_binReader->readSharkNum());
+
+        bool isFound = false;
+        for (uint32_t i = 0; i < num && !isFound && !m_isCorrupted; ++i) {
+            const uint32_t string = readString();
+            const int attachCode = m_binReader->readByte();
+            if (m_strings[string] != name) {
+                const size_t start = m_binReader->getPosition();
+                skipValue(attachCode);
+                m_bytesSkipped += m_binReader->getPosition() - start;
+                continue;
+            }
+
+            if (separator == std::string_view::npos) {
+                auto document = std::make_unique<SharkDocument>();
+                m_document = document.get();
+                document->m_source = m_binReader;
+                document->m_nodes.emplace_back();
+                SharkNode root = readValue(atom(string), attachCode);
+                document->m_nodes[0] = root;
+                if (!m_isCorrupted && (root.type == SharkNodeType::Sub || root.type == SharkNodeType::ArraySub))
+                    readSubtree(0);
+                document->bindPools();
+                m_document = nullptr;
+                return m_isCorrupted ? nullptr : std::move(document);
+            }
+
+            // Like SharkNode::goSub, the first child of the name is followed and only a Sub has children
+            if (attachCode != 0x40)
+                return nullptr;
+            isFound = true;
+        }
+
+        if (!isFound)
+            return nullptr;
+        path.remove_prefix(separator + 1);
+    }
+}
+
+bool SharkReader::visit(SharkVisitor& visitor) {
+    rewind(nullptr);
+    visitSub(visitor);
+    return !m_isCorrupted;
+}
+
+size_t SharkReader::bytesSkipped() const {
+    return m_bytesSkipped;
+}
+
+void SharkReader::rewind(SharkDocument* document) {
+    m_binReader->setPosition(m_rootPosition);
+    m_numStrings = 0;
+    m_isCorrupted = false;
+    m_document = document;
+    m_atoms.assign(m_strings.size(), SharkDocument::noAtom);
+}
+
+uint32_t SharkReader::readString() {
+    int64_t num = m_binReader->readSharkNum();
+    if (num == 0) {
+        if (m_numStrings == m_strings.size()) {
+            m_strings.push_back(m_binReader->viewStringLine());
+            m_atoms.push_back(SharkDocument::noAtom);
+        }
+        else {
+            m_binReader->shiftPosition(static_cast<int64_t>(m_strings[m_numStrings].size()) + 1);
+        }
+        return m_numStrings++;
+    }
+
+    if (num < 0 || num > m_numStrings)
+        throw std::exception("shark3d string reference out of range");
+    return m_numStrings - static_cast<uint32_t>(num);
+}
+
+uint32_t SharkReader::atom(uint32_t string) {
+    if (m_atoms[string] == SharkDocument::noAtom)
+        m_atoms[string] = m_document->intern(m_strings[string]);
+    return m_atoms[string];
+}
+
+void SharkReader::skipValue(int attachCode) {
+    switch (attachCode) {
+    case 0:
+        break;
+    case 1:
+        m_binReader->readSharkNum();
+        break;
+    case 2:
+        for (int64_t e = m_binReader->readSharkNum(); e > 0; e--)
+            m_binReader->readSharkNum();
+        break;
+    case 4:
+        m_binReader->shiftPosition(sizeof(float));
+        break;
+    case 8:
+        m_binReader->shiftPosition(m_binReader->readSharkNum() * static_cast<int64_t>(sizeof(float)));
+        break;
+    case 0x10:
+        readString();
+        break;
+    case 0x20:
+        for (int64_t e = m_binReader->readSharkNum(); e > 0; e--)
+            readString();
+        break;
+    case 0x40:
+        skipSub();
+        break;
+    case 0x80:
+        for (int64_t e = m_binReader->readSharkNum(); e > 0 && !m_isCorrupted; e--)
+            skipSub();
+        break;
+    default:
+        spdlog::error("Unrecognized code in shark3d binary!");
+        m_isCorrupted = true;
+        break;
+    }
+}
+
+void SharkReader::skipSub() {
+    // Opens a Sub unless an earlier pass recorded where it ends
+    auto enterSub = [this] {
+        const size_t start = m_binReader->getPosition();
+        if (auto it = m_skippedSubs.find(start); it != m_skippedSubs.end()) {
+            m_binReader->setPosition(it->second.end);
+            m_numStrings = it->second.numStrings;
+            return;
+        }
+        m_openSubs.push_back(OpenSub{start, m_binReader->readSharkNum(), false});
+    };
+
+    m_openSubs.clear();
+    enterSub();
+    while (!m_openSubs.empty() && !m_isCorrupted) {
+        OpenSub& sub = m_openSubs.back();
+        if (sub.remaining <= 0) {
+            if (!sub.isArray)
+                m_skippedSubs.emplace(sub.start, SkippedSub{m_binReader->getPosition(), m_numStrings});
+            m_openSubs.pop_back();
+            continue;
+        }
+
+        --sub.remaining;
+        if (sub.isArray) {
+            enterSub();
+            continue;
+        }
+        readString();
+        const int attachCode = m_binReader->readByte();
+        if (attachCode == 0x40)
+            enterSub();
+        else if (attachCode == 0x80)
+            m_openSubs.push_back(OpenSub{m_binReader->getPosition(), m_binReader->readSharkNum(), true});
+        else
+            skipValue(attachCode);
+    }
+}
+
+void SharkReader::visitSub(SharkVisitor& visitor) {
+    m_openSubs.clear();
+    visitor.beginSub("root");
+    m_openSubs.push_back(OpenSub{m_rootPosition, m_binReader->readSharkNum(), false});
+    while (!m_openSubs.empty() && !m_isCorrupted) {
+        OpenSub& sub = m_openSubs.back();
+        if (sub.remaining <= 0) {
+            if (sub.isArray)
+                visitor.endArray();
+            else
+                visitor.endSub();
+            m_openSubs.pop_back();
+            continue;
+        }
+
+        --sub.remaining;
+        if (sub.isArray) {
+            visitor.beginSub({});
+            m_openSubs.push_back(OpenSub{m_binReader->getPosition(), m_binReader->readSharkNum(), false});
+            continue;
+        }
+
+        const std::string_view name = m_strings[readString()];
+        const int attachCode = m_binReader->readByte();
+        switch (attachCode) {
+        case 0:
+            visitor.empty(name);
+            break;
+        case 1:
+            visitor.value(name, m_binReader->readSharkNum());
+            break;
+        case 2: {
+            const int64_t count = m_binReader->readSharkNum();
+            visitor.beginArray(name, SharkNodeType::ArrayInt, static_cast<size_t>(count));
+            for (int64_t e = 0; e < count; e++)
+                visitor.value({}, m_binReader->readSharkNum());
+            visitor.endArray();
+            break;
+        }
+        case 4:
+            visitor.value(name, m_binReader->readEndianFloat());
+            break;
+        case 8: {
+            const int64_t count = m_binReader->readSharkNum();
+            visitor.beginArray(name, SharkNodeType::ArrayFloat, static_cast<size_t>(count));
+            for (int64_t e = 0; e < count; e++)
+                visitor.value({}, m_binReader->readEndianFloat());
+            visitor.endArray();
+            break;
+        }
+        case 0x10:
+            visitor.value(name, m_strings[readString()]);
+            break;
+        case 0x20: {
+            const int64_t count = m_binReader->readSharkNum();
+            visitor.beginArray(name, SharkNodeType::ArrayString, static_cast<size_t>(count));
+            for (int64_t e = 0; e < count; e++)
+                visitor.value({}, m_strings[readString()]);
+            visitor.endArray();
+            break;
+        }
+        case 0x40:
+            visitor.beginSub(name);
+            m_openSubs.push_back(OpenSub{m_binReader->getPosition(), m_binReader->readSharkNum(), false});
+            break;
+        case 0x80: {
+            const int64_t count = m_binReader->readSharkNum();
+            visitor.beginArray(name, SharkNodeType::ArraySub, static_cast<size_t>(count));
+            m_openSubs.push_back(OpenSub{m_binReader->getPosition(), count, true});
+            break;
+        }
+        default:
+            spdlog::error("Unrecognized code in shark3d binary!");
+            m_isCorrupted = true;
+            break;
+        }
+    }
+
+    // A corrupted file still closes everything the visitor has seen opened
+    for (auto it = m_openSubs.rbegin(); it != m_openSubs.rend(); ++it) {
+        if (it->isArray)
+            visitor.endArray();
+        else
+            visitor.endSub();
+    }
+    m_openSubs.clear();
+}
+
+void SharkReader::readSubtree(uint32_t index) {
+    std::vector<SharkNode>& nodes = m_document->m_nodes;
+    m_openNodes.clear();
+    if (nodes[index].type == SharkNodeType::Sub)
+        beginSub(index);
+    else
+        m_openNodes.push_back(OpenNode{index, 0});
+
+    // Nested blocks are appended while the loop runs, so nodes are addressed by index
+    while (!m_openNodes.empty()) {
+        OpenNode& open = m_openNodes.back();
+        const SharkNode& parent = nodes[open.index];
+        if (open.next == parent.length) {
+            m_openNodes.pop_back();
+            continue;
+        }
+
+        const uint32_t child = parent.offset + open.next++;
+        if (parent.type == SharkNodeType::ArraySub) {
+            // Elements are Subs named like the array
+            nodes[child] = SharkNode{SharkNodeType::Sub, parent.nameId, 0, 0, m_document};
+            beginSub(child);
+            continue;
+        }
+
+        const uint32_t nameId = atom(readString());
+        const SharkNode node = readValue(nameId, m_binReader->readByte());
+        if (m_isCorrupted) {
+            // Nothing below `index` is kept
+            nodes.resize(index + 1);
+            nodes[index].offset = index + 1;
+            nodes[index].length = 0;
+            m_openNodes.clear();
+            return;
+        }
+        nodes[child] = node;
+        if (node.type == SharkNodeType::Sub)
+            beginSub(child);
+        else if (node.type == SharkNodeType::ArraySub)
+            m_openNodes.push_back(OpenNode{child, 0});
+    }
+}
+
+void SharkReader::beginSub(uint32_t index) {
+    std::vector<SharkNode>& nodes = m_document->m_nodes;
+    const uint32_t num = static_cast<uint32_t>(m_binReader->readSharkNum());
+    const uint32_t first = static_cast<uint32_t>(nodes.size());
+    nodes.resize(first + num);
+    nodes[index].offset = first;
+    nodes[index].length = num;
+    m_openNodes.push_back(OpenNode{index, 0});
+}
+
+SharkNode SharkReader::readValue(uint32_t nameId, int attachCode) {
+    SharkDocument& document = *m_document;
+    SharkNode node{SharkNodeType::Empty, nameId, 0, 0, m_document};
+    switch (attachCode) {
+    case 0:
+        break;
+    case 1:
+        node.type = SharkNodeType::Int;
+        node.offset = static_cast<uint32_t>(document.m_parsedInts.size());
+        node.length = 1;
+        document.m_parsedInts.push_back(m_binReader->readSharkNum());
+        break;
+    case 2:
+        node.type = SharkNodeType::ArrayInt;
+        node.offset = static_cast<uint32_t>(document.m_parsedInts.size());
+        node.length = static_cast<uint32_t>(m_binReader->readSharkNum());
+        for (uint32_t e = 0; e < node.length; e++)
+            document.m_parsedInts.push_back(m_binReader->readSharkNum());
+        break;
+    case 4:
+        node.type = SharkNodeType::Float;
+        node.offset = static_cast<uint32_t>(document.m_parsedFloats.size());
+        node.length = 1;
+        document.m_parsedFloats.push_back(m_binReader->readEndianFloat());
+        break;
+    case 8:
+        node.type = SharkNodeType::ArrayFloat;
+        node.offset = static_cast<uint32_t>(document.m_parsedFloats.size());
+        node.length = static_cast<uint32_t>(m_binReader->readSharkNum());
+        document.m_parsedFloats.resize(node.offset + node.length);
+        m_binReader->readEndianFloats(document.m_parsedFloats.data() + node.offset, node.length);
+        break;
+    case 0x10: {
+        uint32_t stringId = atom(readString());
+        node.type = SharkNodeType::String;
+        node.offset = static_cast<uint32_t>(document.m_parsedStringIds.size());
+        node.length = 1;
+        document.m_parsedStringIds.push_back(stringId);
+        break;
+    }
+    case 0x20: {
+        node.type = SharkNodeType::ArrayString;
+        node.length = static_cast<uint32_t>(m_binReader->readSharkNum());
+        node.offset = static_cast<uint32_t>(document.m_parsedStringIds.size());
+        document.m_parsedStringIds.resize(node.offset + node.length);
+        for (uint32_t e = 0; e < node.length; e++)
+            document.m_parsedStringIds[node.offset + e] = atom(readString());
+        break;
+    }
+    case 0x40:
+        node.type = SharkNodeType::Sub;
+        break;
+    case 0x80:
+        node.type = SharkNodeType::ArraySub;
+        node.length = static_cast<uint32_t>(m_binReader->readSharkNum());
+        node.offset = static_cast<uint32_t>(document.m_nodes.size());
+        document.m_nodes.resize(node.offset + node.length);
+        break;
+    default:
+        spdlog::error("Unrecognized code in shark3d binary!");
+        m_isCorrupted = true;
+        break;
+    }
+    return node;
+}
+
+} // namespace parser
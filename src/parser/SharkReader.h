@@ -0,0 +1,116 @@
+#pragma once
+
+#include "SharkNode.h"
+
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace parser {
+
+class BinReaderMmap;
+
+// Entries of a shark3d file in file order, see SharkReader::visit. Elements of arrays are values with an empty name,
+// the Sub elements of an ArraySub come as beginSub("") / endSub().
+class SharkVisitor {
+public:
+    virtual ~SharkVisitor() = default;
+
+    virtual void beginSub(std::string_view name) = 0;
+    virtual void endSub() = 0;
+    // `type` is ArrayInt, ArrayFloat, ArrayString or ArraySub
+    virtual void beginArray(std::string_view name, SharkNodeType type, size_t count) = 0;
+    virtual void endArray() = 0;
+
+    virtual void empty(std::string_view name) = 0;
+    virtual void value(std::string_view name, int64_t value) = 0;
+    virtual void value(std::string_view name, float value) = 0;
+    virtual void value(std::string_view name, std::string_view value) = 0;
+};
+
+// Pull-based reader of a shark3d binary. Only the requested path is built into a SharkDocument, entries on the
+// way to it are stepped over without allocating nodes. The format has no sizes, so the first pass over a skipped
+// Sub still decodes it, but its end is recorded and later reads of the same file jump over it.
+class SharkReader {
+public:
+    // Extracts the file from its .pak first, see PackageParser::tryExtract
+    explicit SharkReader(const std::filesystem::path& path);
+    // Reads an already mapped file, touches no shared state
+    explicit SharkReader(std::shared_ptr<BinReaderMmap> file);
+    ~SharkReader();
+
+    // The whole file, under a root named "root"
+    std::unique_ptr<SharkDocument> readAll();
+    // Only the node at `path` and its subtree, the node becomes the root of the document.
+    // Names are matched like SharkNode::goSub does. nullptr if the file has no such node.
+    std::unique_ptr<SharkDocument> read(std::string_view path);
+
+    // Streams the whole file to `visitor` without building a document, the root is a Sub named "root".
+    // False if the file has an unknown entry, the visitor has seen the entries before it.
+    bool visit(SharkVisitor& visitor);
+
+    // Bytes stepped over by read, summed over all calls
+    size_t bytesSkipped() const;
+
+private:
+    // Where the stream continues after a skipped Sub, and how many strings it has introduced by then
+    struct SkippedSub {
+        size_t end;
+        uint32_t numStrings;
+    };
+
+    // Sub or ArraySub of m_document whose block of children is being filled
+    struct OpenNode {
+        uint32_t index;
+        uint32_t next;
+    };
+
+    // Sub or ArraySub in the stream with entries, or elements, left to skip or visit
+    struct OpenSub {
+        size_t start;
+        int64_t remaining;
+        bool isArray;
+    };
+
+    void rewind(SharkDocument* document);
+
+    // Index of the string in m_strings. 0 introduces a new string, n refers back to the n-th last one.
+    uint32_t readString();
+    uint32_t atom(uint32_t string);
+
+    void skipValue(int attachCode);
+    void skipSub();
+
+    void visitSub(SharkVisitor& visitor);
+
+    // Reads everything below the Sub or ArraySub at `index`. Nesting is kept on m_openNodes instead of the call
+    // stack, so deep documents don't depend on the stack size of the thread. Blocks of children are appended in
+    // depth-first order.
+    void readSubtree(uint32_t index);
+    // Allocates the block of children of the Sub at `index` and opens it
+    void beginSub(uint32_t index);
+    // Sub and ArraySub come back without their children, an ArraySub with its block of elements allocated
+    SharkNode readValue(uint32_t nameId, int attachCode);
+
+    std::shared_ptr<BinReaderMmap> m_binReader; // shared with the documents, their atoms point into it
+    size_t m_rootPosition = 0;
+    bool m_isCorrupted = false;
+
+    // Strings in the order the file introduces them, they point into the mapped file. Entries past
+    // m_numStrings were read by an earlier pass and are reused when the stream reaches them again.
+    std::vector<std::string_view> m_strings;
+    uint32_t m_numStrings = 0;
+    std::unordered_map<size_t, SkippedSub> m_skippedSubs; // by the position of their entry count
+    size_t m_bytesSkipped = 0;
+
+    SharkDocument* m_document = nullptr; // being built
+    std::vector<uint32_t> m_atoms; // atom of each string in m_document, noAtom until interned
+
+    // Kept between calls so they're allocated once per reader
+    std::vector<OpenNode> m_openNodes;
+    std::vector<OpenSub> m_openSubs;
+};
+
+} // namespace parser
@@ -0,0 +1,197 @@
+#include "Skin.h"
+#include "BundleHeader.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace parser {
+
+namespace {
+
+const int boneDataSize = 7;
+const SkinVertex unboundVertex{};
+// boneAssign weights are 16-bit fixed point
+const uint32_t fullWeight = 0xffff;
+
+struct Influence {
+    uint8_t slot;
+    uint32_t weight;
+};
+
+// The heaviest four influences with their weights scaled to 255, an all-zero run is shared equally
+SkinVertex packInfluences(std::vector<Influence>& influences) {
+    std::stable_sort(influences.begin(), influences.end(), [](const Influence& a, const Influence& b) { return a.weight > b.weight; });
+    const size_t count = std::min(influences.size(), maxInfluences);
+    uint32_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+        total += influences[i].weight;
+
+    SkinVertex skinVertex = unboundVertex;
+    uint32_t sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t weight = total == 0 ? 1 : influences[i].weight;
+        const uint32_t divisor = total == 0 ? static_cast<uint32_t>(count) : total;
+        skinVertex.bones[i] = influences[i].slot;
+        skinVertex.weights[i] = static_cast<uint8_t>((weight * 255 + divisor / 2) / divisor);
+        sum += skinVertex.weights[i];
+    }
+    // Rounding is settled on the heaviest bone, so the weights always sum to 255
+    if (count > 0)
+        skinVertex.weights[0] = static_cast<uint8_t>(skinVertex.weights[0] + 255 - sum);
+    return skinVertex;
+}
+
+} // namespace
+
+BoneMatrix BoneMatrix::fromPose(const Vector3& position, const Quaternion& rotation) {
+    const float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    BoneMatrix matrix;
+    matrix.rows[0] = Vector4{1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - w * z), 2.0f * (x * z + w * y), position.x};
+    matrix.rows[1] = Vector4{2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - w * x), position.y};
+    matrix.rows[2] = Vector4{2.0f * (x * z - w * y), 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + y * y), position.z};
+    return matrix;
+}
+
+BoneMatrix BoneMatrix::inverseRigid() const {
+    // The rotation is transposed, the translation rotated back and negated
+    const Vector4& a = rows[0];
+    const Vector4& b = rows[1];
+    const Vector4& c = rows[2];
+    BoneMatrix inverse;
+    inverse.rows[0] = Vector4{a.x, b.x, c.x, -(a.x * a.w + b.x * b.w + c.x * c.w)};
+    inverse.rows[1] = Vector4{a.y, b.y, c.y, -(a.y * a.w + b.y * b.w + c.y * c.w)};
+    inverse.rows[2] = Vector4{a.z, b.z, c.z, -(a.z * a.w + b.z * b.w + c.z * c.w)};
+    return inverse;
+}
+
+BoneMatrix BoneMatrix::operator*(const BoneMatrix& other) const {
+    BoneMatrix result;
+    for (int r = 0; r < 3; ++r) {
+        const Vector4& row = rows[r];
+        result.rows[r] = Vector4{row.x * other.rows[0].x + row.y * other.rows[1].x + row.z * other.rows[2].x,
+                                 row.x * other.rows[0].y + row.y * other.rows[1].y + row.z * other.rows[2].y,
+                                 row.x * other.rows[0].z + row.y * other.rows[1].z + row.z * other.rows[2].z,
+                                 row.x * other.rows[0].w + row.y * other.rows[1].w + row.z * other.rows[2].w + row.w};
+    }
+    return result;
+}
+
+Vector3 BoneMatrix::transform(const Vector3& p) const {
+    return Vector3{rows[0].x * p.x + rows[0].y * p.y + rows[0].z * p.z + rows[0].w,
+                   rows[1].x * p.x + rows[1].y * p.y + rows[1].z * p.z + rows[1].w,
+                   rows[2].x * p.x + rows[2].y * p.y + rows[2].z * p.z + rows[2].w};
+}
+
+size_t SkinVertex::numInfluences() const {
+    size_t count = 0;
+    while (count < maxInfluences && weights[count] != 0)
+        ++count;
+    return count;
+}
+
+bool Skin::empty() const {
+    return vertices.empty();
+}
+
+std::vector<BoneMatrix> Skin::bindPose() const {
+    std::vector<BoneMatrix> palette(bones.size());
+    for (size_t i = 0; i < bones.size(); ++i)
+        palette[i] = BoneMatrix::fromPose(bones[i].position, bones[i].rotation);
+    return palette;
+}
+
+std::vector<BoneMatrix> Skin::skinningPalette(std::span<const BoneMatrix> pose) const {
+    std::vector<BoneMatrix> palette(bones.size());
+    for (size_t i = 0; i < bones.size(); ++i)
+        palette[i] = pose[i] * BoneMatrix::fromPose(bones[i].position, bones[i].rotation).inverseRigid();
+    return palette;
+}
+
+// Stages are read in order. A stage's boneAssign weight is added to the open run, and stages whose weights add up to
+// 1.0 share one run of boneVertices vertices, which blends their bones. Without boneAssign every stage has the full
+// weight, so each run follows a single bone. A stage with a different vertex count closes the open run.
+void Skin::appendPart(const MeshInfo& info, const MeshPartInfo& part, size_t baseVertex, size_t numVertices) {
+    vertices.resize(baseVertex, unboundVertex);
+    vertices.resize(baseVertex + numVertices, unboundVertex);
+
+    std::vector<Influence> run;
+    uint32_t runWeight = 0;
+    int runStages = 0;
+    size_t vertex = baseVertex;
+    const size_t end = baseVertex + numVertices;
+    auto closeRun = [&](uint16_t numRunVertices) {
+        if (runWeight != fullWeight && part.boneAssign.has_value())
+            spdlog::debug("{}: bone weights of a run sum to {}", info.name, runWeight / static_cast<float>(fullWeight));
+        const size_t runEnd = std::min(end, vertex + numRunVertices);
+        std::fill(vertices.begin() + vertex, vertices.begin() + runEnd, packInfluences(run));
+        vertex = runEnd;
+        run.clear();
+        runWeight = 0;
+        runStages = 0;
+    };
+
+    for (int stage = 0; stage < part.header.numBoneStages && vertex < end; ++stage) {
+        if (runStages > 0 && part.boneVertices[stage] != part.boneVertices[stage - 1])
+            closeRun(part.boneVertices[stage - 1]);
+
+        const uint32_t weight = part.boneAssign.has_value() ? (*part.boneAssign)[stage] : fullWeight;
+        runWeight += weight;
+        ++runStages;
+        const int meshBone = part.boneIndices[stage];
+        auto it = std::find_if(bones.begin(), bones.end(), [&](const Bone& bone) { return bone.meshBone == meshBone; });
+        if (meshBone >= static_cast<int>(info.boneNames.size())) {
+            spdlog::warn("{}: bone {} is out of {} bones", info.name, meshBone, info.boneNames.size());
+        }
+        else if (it == bones.end() && bones.size() > std::numeric_limits<uint8_t>::max()) {
+            spdlog::warn("{}: more than 256 bones are used, bone {} is not bound", info.name, info.boneNames[meshBone]);
+        }
+        else {
+            if (it == bones.end()) {
+                // boneData is position and rotation quaternion per bone
+                const float* data = info.boneData.data() + boneDataSize * meshBone;
+                it = bones.insert(bones.end(),
+                                  Bone{std::string(info.boneNames[meshBone]),
+                                       meshBone,
+                                       Vector3{data[0], data[1], data[2]},
+                                       Quaternion{data[3], data[4], data[5], data[6]}});
+            }
+            run.push_back(Influence{static_cast<uint8_t>(it - bones.begin()), weight});
+        }
+
+        if (runWeight >= fullWeight || stage + 1 == part.header.numBoneStages)
+            closeRun(part.boneVertices[stage]);
+    }
+
+    if (vertex != end)
+        spdlog::warn("{}: bone stages bind {} of {} vertices", info.name, vertex - baseVertex, numVertices);
+}
+
+void skinPositions(std::span<const BoneMatrix> palette,
+                   std::span<const SkinVertex> skinVertices,
+                   std::span<const Vector3> positions,
+                   std::span<Vector3> result) {
+    const float weightScale = 1.0f / 255.0f;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const SkinVertex& skinVertex = skinVertices[i];
+        const Vector3& position = positions[i];
+        // Vertices of single bone runs skip the blend
+        if (skinVertex.weights[0] == 255 || skinVertex.weights[0] == 0) {
+            result[i] = skinVertex.weights[0] == 255 ? palette[skinVertex.bones[0]].transform(position) : position;
+            continue;
+        }
+
+        Vector3 blended{0.0f, 0.0f, 0.0f};
+        for (size_t k = 0; k < maxInfluences && skinVertex.weights[k] != 0; ++k) {
+            const Vector3 p = palette[skinVertex.bones[k]].transform(position);
+            const float weight = skinVertex.weights[k] * weightScale;
+            blended.x += p.x * weight;
+            blended.y += p.y * weight;
+            blended.z += p.z * weight;
+        }
+        result[i] = blended;
+    }
+}
+
+} // namespace parser
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Geometry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace parser {
+
+struct MeshInfo;
+struct MeshPartInfo;
+
+const size_t maxInfluences = 4;
+
+// Up to four bones per vertex, 8 bytes: palette slots and 8-bit weights summing to 255, the heaviest first. Unused
+// influences have weight 0, vertices outside every bone stage have none and keep their position.
+struct SkinVertex {
+    uint8_t bones[maxInfluences];
+    uint8_t weights[maxInfluences];
+
+    size_t numInfluences() const;
+};
+
+struct Bone {
+    std::string name;
+    int meshBone;        // index into MeshInfo::boneNames
+    Vector3 position;    // bind pose from MeshInfo::boneData
+    Quaternion rotation; // bind pose from MeshInfo::boneData
+};
+
+// Row-major 3x4 matrix, the translation is the last column
+struct BoneMatrix {
+    Vector4 rows[3];
+
+    static BoneMatrix fromPose(const Vector3& position, const Quaternion& rotation);
+
+    // Inverse of a rotation and translation, bone poses have no scale
+    BoneMatrix inverseRigid() const;
+    BoneMatrix operator*(const BoneMatrix& other) const;
+    Vector3 transform(const Vector3& p) const;
+};
+
+struct Skin {
+    std::vector<Bone> bones;          // palette, only the bones the mesh vertices are bound to
+    std::vector<SkinVertex> vertices; // parallel to Mesh::vertices, empty for static meshes
+
+    bool empty() const;
+
+    // Matrices of the palette bones in their bind pose
+    std::vector<BoneMatrix> bindPose() const;
+    // Matrices for skinPositions: `pose` of each palette bone times the inverse of its bind pose.
+    // The bind pose itself gives identities.
+    std::vector<BoneMatrix> skinningPalette(std::span<const BoneMatrix> pose) const;
+
+    // Binds the vertices of a part starting at `baseVertex`. Stage s of the part gives bone boneIndices[s] the weight
+    // boneAssign[s] over a run of boneVertices[s] vertices, see Skin.cpp.
+    void appendPart(const MeshInfo& info, const MeshPartInfo& part, size_t baseVertex, size_t numVertices);
+};
+
+// Linear blend skinning of `positions` into `result` with the matrices of Skin::skinningPalette
+void skinPositions(std::span<const BoneMatrix> palette,
+                   std::span<const SkinVertex> skinVertices,
+                   std::span<const Vector3> positions,
+                   std::span<Vector3> result);
+
+} // namespace parser
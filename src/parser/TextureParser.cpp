@@ -18,6 +18,8 @@
 #include <spdlog/spdlog.h>
 
 #include <locale>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <queue>
 #include <sstream>
@@ -248,6 +250,14 @@ bool loadNML(const std::filesystem::path& path, const std::filesystem::path& exp
 
     return false;
 }
+// Scenes of a bundle share textures, a texture is converted by one thread while the others wait for it
+std::mutex& exportMutex(const std::filesystem::path& exportPath) {
+    static std::mutex mutex;
+    static std::map<std::string, std::mutex> exportMutexes;
+    std::lock_guard lock(mutex);
+    return exportMutexes[exportPath.string()];
+}
+
 } // namespace
 
 void parseTextures(MeshPart& meshPart, const std::vector<std::filesystem::path>& texturesPath, const std::filesystem::path& exportFolder) {
@@ -259,6 +269,7 @@ void parseTextures(MeshPart& meshPart, const std::vector<std::filesystem::path>&
         PackageParser::instance().tryExtract(texturesPath[i]);
 
         std::filesystem::path exportPath = exportFolder / texturesPath[i];
+        std::lock_guard exportLock(exportMutex(exportPath));
         bool isLoaded = std::filesystem::exists(exportPath);
         if (!isLoaded) {
             std::filesystem::create_directories(exportPath.parent_path());
@@ -0,0 +1,152 @@
+#include "ThreadPool.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+
+namespace parser {
+
+ThreadPool::ThreadPool(size_t numThreads, Job onThreadStart)
+        : m_onThreadStart(std::move(onThreadStart)) {
+    numThreads = std::max<size_t>(numThreads, 1);
+    for (size_t i = 0; i < numThreads; ++i)
+        m_queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < numThreads; ++i)
+        m_threads.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_jobAdded.notify_all();
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::submit(Job job) {
+    size_t index = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        index = m_nextQueue++ % m_queues.size();
+        ++m_numQueued;
+        ++m_numPending;
+    }
+    {
+        std::lock_guard lock(m_queues[index]->mutex);
+        m_queues[index]->jobs.push_back(std::move(job));
+    }
+    m_jobAdded.notify_one();
+}
+
+void ThreadPool::submit(Job job, Group& group) {
+    {
+        std::lock_guard lock(m_mutex);
+        ++group.numPending;
+    }
+    submit([this, job = std::move(job), &group] {
+        struct Done {
+            ThreadPool& pool;
+            Group& group;
+            ~Done() {
+                std::lock_guard lock(pool.m_mutex);
+                if (--group.numPending == 0)
+                    pool.m_jobsDone.notify_all();
+            }
+        } done{*this, group};
+        job();
+    });
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(m_mutex);
+    m_jobsDone.wait(lock, [this] { return m_numPending == 0; });
+}
+
+void ThreadPool::wait(Group& group) {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(m_mutex);
+            if (group.numPending == 0)
+                return;
+            // Jobs taken by the workers are waited for, queued ones are run here
+            m_jobsDone.wait(lock, [&] { return group.numPending == 0 || m_numQueued > 0; });
+            if (group.numPending == 0)
+                return;
+        }
+        if (pop(0, job)) {
+            {
+                std::lock_guard lock(m_mutex);
+                --m_numQueued;
+            }
+            execute(job);
+        }
+    }
+}
+
+size_t ThreadPool::size() const {
+    return m_threads.size();
+}
+
+bool ThreadPool::pop(size_t index, Job& job) {
+    for (size_t i = 0; i < m_queues.size(); ++i) {
+        Queue& queue = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+
+        if (i == 0) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::execute(Job& job) {
+    try {
+        job();
+    }
+    catch (const std::exception& exception) {
+        spdlog::error("Job failed: {}", exception.what());
+    }
+    catch (...) {
+        spdlog::error("Job failed");
+    }
+
+    std::lock_guard lock(m_mutex);
+    if (--m_numPending == 0)
+        m_jobsDone.notify_all();
+}
+
+void ThreadPool::run(size_t index) {
+    if (m_onThreadStart)
+        m_onThreadStart();
+
+    while (true) {
+        Job job;
+        if (pop(index, job)) {
+            {
+                std::lock_guard lock(m_mutex);
+                --m_numQueued;
+            }
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock lock(m_mutex);
+        m_jobAdded.wait(lock, [this] { return m_isStopping || m_numQueued > 0; });
+        if (m_isStopping && m_numQueued == 0)
+            return;
+    }
+}
+
+} // namespace parser
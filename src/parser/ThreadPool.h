@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parser {
+
+// Fixed set of workers with a job deque each. A worker runs its newest job first
+// and steals the oldest job of another worker once its own deque is empty.
+class ThreadPool {
+public:
+    using Job = std::function<void()>;
+
+    // `onThreadStart` runs once on every worker before its first job
+    explicit ThreadPool(size_t numThreads, Job onThreadStart = {});
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Jobs submitted with a group can be waited for apart from the other jobs of the pool
+    struct Group {
+        size_t numPending = 0; // guarded by the mutex of the pool
+    };
+
+    void submit(Job job);
+    void submit(Job job, Group& group);
+    // Blocks until every submitted job has finished
+    void wait();
+    // Runs jobs of the pool until the jobs of `group` have finished, so a worker waits for a group without taking a
+    // thread from the jobs it waits for
+    void wait(Group& group);
+
+    size_t size() const;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void run(size_t index);
+    bool pop(size_t index, Job& job);
+    // Runs a popped job and counts it as finished
+    void execute(Job& job);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    Job m_onThreadStart;
+
+    std::mutex m_mutex;
+    std::condition_variable m_jobAdded;
+    std::condition_variable m_jobsDone;
+    size_t m_numQueued = 0;  // submitted and not taken by a worker yet
+    size_t m_numPending = 0; // submitted and not finished yet
+    size_t m_nextQueue = 0;
+    bool m_isStopping = false;
+};
+
+} // namespace parser
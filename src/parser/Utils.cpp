@@ -24,4 +24,39 @@ std::string getFilenameWithoutExtension(const std::filesystem::path& path) {
     return path.filename().replace_extension().string();
 }
 
+bool matchesGlob(const std::string& text, const std::string& pattern) {
+    size_t t = 0, p = 0;
+    size_t starPattern = std::string::npos, starText = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starText = t;
+        }
+        else if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++t;
+            ++p;
+        }
+        else if (starPattern != std::string::npos) {
+            p = starPattern + 1;
+            t = ++starText;
+        }
+        else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+    return p == pattern.size();
+}
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
 } // namespace Utils
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -10,4 +11,10 @@ std::vector<std::string> splitString(const std::string& s, char delimiter);
 std::string getFilenameWithoutExtension(const std::string& path);
 std::string getFilenameWithoutExtension(const std::filesystem::path& path);
 
+// '*' matches any run of characters, '?' a single one
+bool matchesGlob(const std::string& text, const std::string& pattern);
+
+// FNV-1a, chained through `seed`
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
 } // namespace Utils
@@ -0,0 +1,151 @@
+#include "VertexDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace parser {
+
+namespace {
+
+const size_t entrySize[] = {0, 8, 12, 16, 4};
+const std::string entryName[] = {"Unused", "Float2", "Float3", "Float4", "Color"};
+const ChannelType entryType[] = {ChannelType::Unused, ChannelType::Float2, ChannelType::Float3, ChannelType::Float4, ChannelType::Color};
+
+// One instantiation per attribute type, a single memcpy when the stream holds only this attribute
+template <typename T>
+void copyStrided(T* destination, const char* source, size_t stride, size_t count) {
+    if (stride == sizeof(T)) {
+        std::memcpy(destination, source, count * sizeof(T));
+        return;
+    }
+    for (size_t i = 0; i < count; ++i, source += stride)
+        std::memcpy(destination + i, source, sizeof(T));
+}
+
+// Optional streams are padded with `fill` up to `base` first, so they stay aligned with the positions
+// when only some of the parts appended to a mesh have them
+template <typename T>
+T* appendStrided(std::vector<T>& stream, size_t base, const T& fill, const char* source, size_t stride, size_t count) {
+    stream.resize(base, fill);
+    stream.resize(base + count);
+    copyStrided(stream.data() + base, source, stride, count);
+    return stream.data() + base;
+}
+
+template <typename T>
+void padStream(std::vector<T>& stream, size_t size, const T& fill) {
+    if (!stream.empty())
+        stream.resize(size, fill);
+}
+
+// uv = (u, 1 - v), done over the interleaved floats so the loop has no stride and vectorizes
+void flipV(Vector2* uvs, size_t count) {
+    static_assert(sizeof(Vector2) == 2 * sizeof(float));
+    float* values = &uvs->x;
+    const float scale[2] = {1.0f, -1.0f};
+    const float bias[2] = {0.0f, 1.0f};
+    for (size_t i = 0; i < 2 * count; ++i)
+        values[i] = values[i] * scale[i & 1] + bias[i & 1];
+}
+
+} // namespace
+
+VertexLayout VertexLayout::compile(const StreamFormat& streamFormat) {
+    VertexLayout layout;
+    for (int i = 0; i < 16; ++i) {
+        int channel = streamFormat.channel[i];
+        if (channel < 0 || channel >= static_cast<int>(std::size(entryType)))
+            continue;
+
+        ChannelType type = entryType[channel];
+        int index = static_cast<int>(layout.channels.size());
+        if (type == ChannelType::Float3 && layout.position == -1)
+            layout.position = index;
+        else if (type == ChannelType::Float3 && layout.normal == -1 && index == layout.position + 1)
+            layout.normal = index;
+        else if (type == ChannelType::Float2 && layout.uv == -1)
+            layout.uv = index;
+        else if (type == ChannelType::Float2)
+            layout.extraUvs.push_back(index);
+        else if (type == ChannelType::Color && layout.color == -1)
+            layout.color = index;
+        else if (type == ChannelType::Float4)
+            layout.extraChannels.push_back(index);
+
+        layout.channels.push_back(VertexChannel{type, layout.stride});
+        layout.stride += entrySize[channel];
+    }
+    return layout;
+}
+
+bool VertexLayout::isSupported() const {
+    return position != -1;
+}
+
+std::string VertexLayout::name() const {
+    std::string result;
+    for (const VertexChannel& channel : channels)
+        result += (result.empty() ? "" : " ") + entryName[static_cast<int>(channel.type)];
+    return result;
+}
+
+void decodeVertices(const VertexLayout& layout, const char* data, size_t numVertices, Mesh& mesh) {
+    const size_t stride = layout.stride;
+    const size_t base = mesh.vertices.size();
+    const Vector2 noUv{0.0f, 0.0f};
+    const uint32_t white = 0xFFFFFFFF;
+
+    appendStrided(mesh.vertices, base, Vector3{}, data + layout.channels[layout.position].offset, stride, numVertices);
+    if (layout.normal != -1)
+        appendStrided(mesh.normals, base, Vector3{}, data + layout.channels[layout.normal].offset, stride, numVertices);
+    if (layout.uv != -1) {
+        Vector2* uvs = appendStrided(mesh.uvs, base, noUv, data + layout.channels[layout.uv].offset, stride, numVertices);
+        flipV(uvs, numVertices);
+    }
+
+    if (layout.color != -1)
+        appendStrided(mesh.colors, base, white, data + layout.channels[layout.color].offset, stride, numVertices);
+
+    mesh.extraUvs.resize(std::max(mesh.extraUvs.size(), layout.extraUvs.size()));
+    for (size_t i = 0; i < layout.extraUvs.size(); ++i) {
+        const char* source = data + layout.channels[layout.extraUvs[i]].offset;
+        Vector2* extraUvs = appendStrided(mesh.extraUvs[i], base, noUv, source, stride, numVertices);
+        flipV(extraUvs, numVertices);
+    }
+
+    mesh.extraChannels.resize(std::max(mesh.extraChannels.size(), layout.extraChannels.size()));
+    for (size_t i = 0; i < layout.extraChannels.size(); ++i) {
+        const char* source = data + layout.channels[layout.extraChannels[i]].offset;
+        appendStrided(mesh.extraChannels[i], base, Vector4{}, source, stride, numVertices);
+    }
+
+    const size_t size = mesh.vertices.size();
+    padStream(mesh.normals, size, Vector3{});
+    padStream(mesh.uvs, size, noUv);
+    padStream(mesh.colors, size, white);
+    for (auto& extraUvs : mesh.extraUvs)
+        padStream(extraUvs, size, noUv);
+    for (auto& extraChannel : mesh.extraChannels)
+        padStream(extraChannel, size, Vector4{});
+}
+
+void decodePositionDeltas(const VertexLayout& layout,
+                          const char* data,
+                          size_t numVertices,
+                          const Vector3* basePositions,
+                          uint32_t baseVertex,
+                          std::vector<uint32_t>& vertices,
+                          std::vector<Vector3>& deltas) {
+    const size_t first = deltas.size();
+    vertices.reserve(first + numVertices);
+    Vector3* positions =
+        appendStrided(deltas, first, Vector3{}, data + layout.channels[layout.position].offset, layout.stride, numVertices);
+    for (size_t i = 0; i < numVertices; ++i) {
+        positions[i].x -= basePositions[i].x;
+        positions[i].y -= basePositions[i].y;
+        positions[i].z -= basePositions[i].z;
+        vertices.push_back(baseVertex + static_cast<uint32_t>(i));
+    }
+}
+
+} // namespace parser
\ No newline at end of file
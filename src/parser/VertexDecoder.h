@@ -0,0 +1,59 @@
+#pragma once
+
+#include "BundleHeader.h"
+#include "Mesh.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace parser {
+
+enum class ChannelType
+{
+    Unused,
+    Float2,
+    Float3,
+    Float4,
+    Color
+};
+
+struct VertexChannel {
+    ChannelType type;
+    size_t offset;
+};
+
+// StreamFormat compiled once into the byte offsets of the attributes Mesh stores
+struct VertexLayout {
+    std::vector<VertexChannel> channels;
+    size_t stride = 0;
+
+    // Indices into channels, -1 if the format has no such attribute
+    int position = -1;
+    int normal = -1;
+    int uv = -1;
+    int color = -1;
+    std::vector<int> extraUvs;
+    std::vector<int> extraChannels;
+
+    static VertexLayout compile(const StreamFormat& streamFormat);
+
+    // Decodable as soon as it has a position, wherever that is in the vertex; every other attribute is optional
+    bool isSupported() const;
+    std::string name() const;
+};
+
+// Appends `numVertices` vertices stored as `layout` to the streams of the mesh.
+// Optional streams the mesh already has but the layout lacks are padded with defaults.
+void decodeVertices(const VertexLayout& layout, const char* data, size_t numVertices, Mesh& mesh);
+
+// Appends the position deltas of an animation frame against `basePositions`, vertex indices are offset by `baseVertex`
+void decodePositionDeltas(const VertexLayout& layout,
+                          const char* data,
+                          size_t numVertices,
+                          const Vector3* basePositions,
+                          uint32_t baseVertex,
+                          std::vector<uint32_t>& vertices,
+                          std::vector<Vector3>& deltas);
+
+} // namespace parser
\ No newline at end of file